@@ -0,0 +1,99 @@
+/*
+ * Shared helpers for the build/bench_* tools.
+ *
+ * A bench loads only the plugins it measures, straight from build/plugins, and drives
+ * them through a CoreContext the same way the plugin manager would. Run them from the
+ * repository root after `make`, e.g. `./build/bench_signals emit`.
+ */
+#ifndef _BENCH_H
+#define _BENCH_H
+
+#include "../../include/core_context.h"
+#include "../../include/plugin_api.h"
+#include "../../include/logger.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <time.h>
+
+#ifdef _WIN32
+#include <windows.h>
+#define BENCH_PLUGIN(name) "build/plugins/" name ".dll"
+#define DYNLIB_HANDLE HMODULE
+#define DYNLIB_OPEN(path) LoadLibraryA(path)
+#define DYNLIB_SYM(handle, sym) GetProcAddress(handle, sym)
+#define DYNLIB_CLOSE(handle) FreeLibrary(handle)
+#else
+#include <dlfcn.h>
+#define BENCH_PLUGIN(name) "build/plugins/" name ".so"
+#define DYNLIB_HANDLE void *
+#define DYNLIB_OPEN(path) dlopen(path, RTLD_LAZY)
+#define DYNLIB_SYM(handle, sym) dlsym(handle, sym)
+#define DYNLIB_CLOSE(handle) dlclose(handle)
+#endif
+
+typedef struct
+{
+    DYNLIB_HANDLE handle;
+    PluginAPI api;
+} BenchPlugin;
+
+static inline uint64_t bench_now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+// Loads and initializes a plugin; exits on failure since a bench cannot run without it
+static inline void bench_load(BenchPlugin *plugin, CoreContext *ctx, const char *path)
+{
+    plugin->handle = DYNLIB_OPEN(path);
+    if (!plugin->handle)
+    {
+        fprintf(stderr, "bench: cannot load %s (run make first)\n", path);
+        exit(1);
+    }
+    PluginAPI (*load)(void) = (PluginAPI (*)(void))DYNLIB_SYM(plugin->handle, "Load");
+    if (!load)
+    {
+        fprintf(stderr, "bench: %s has no Load()\n", path);
+        exit(1);
+    }
+    plugin->api = load();
+    if (plugin->api.init && plugin->api.init(ctx) != 0)
+    {
+        fprintf(stderr, "bench: %s failed to initialize\n", path);
+        exit(1);
+    }
+}
+
+static inline void bench_unload(BenchPlugin *plugin, CoreContext *ctx)
+{
+    if (plugin->api.shutdown)
+        plugin->api.shutdown(ctx);
+    DYNLIB_CLOSE(plugin->handle);
+    plugin->handle = NULL;
+}
+
+// Plugins log through their own copy of the core; keep benches quiet unless something breaks
+static inline void bench_context(CoreContext *ctx)
+{
+    logger_set_level(NULL, LL_WARN);
+    core_context_new(ctx, 0);
+}
+
+// Resolves a bound function or exits with the missing key
+static inline void *bench_get(CoreContext *ctx, const char *key)
+{
+    void *fn = ctx->memory.get(&ctx->memory.map, STR((char *)key));
+    if (!fn)
+    {
+        fprintf(stderr, "bench: %s is not bound\n", key);
+        exit(1);
+    }
+    return fn;
+}
+
+#endif /* _BENCH_H */
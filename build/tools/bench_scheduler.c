@@ -0,0 +1,188 @@
+/*
+ * Benchmarks for the Scheduler plugin.
+ *
+ * Usage: bench_scheduler <mode> [options]
+ *   frames [tasks...]
+ *       per-frame update cost with 100k and 1M periodic tasks (intervals of 0.25 to 16 s)
+ *       and a frame every millisecond, versus the linear walk the Scheduler did before the
+ *       timing wheel; also times register and cancel per task
+ */
+#include "bench.h"
+#include "../../plugins/scheduler/scheduler.h"
+
+static CoreContext ctx;
+static BenchPlugin scheduler;
+
+static scheduler_register_fn_t scheduler_register_fn;
+static scheduler_cancel_fn_t scheduler_cancel_fn;
+
+static void load_scheduler(void)
+{
+    bench_load(&scheduler, &ctx, BENCH_PLUGIN("scheduler"));
+    scheduler_register_fn = bench_get(&ctx, CC_SCHEDULER_REGISTER);
+    scheduler_cancel_fn = bench_get(&ctx, CC_SCHEDULER_CANCEL);
+}
+
+// ---------------- frames ----------------
+
+#define FRAMES_RUN_NS 2000000000ull // each variant runs frames for about this long
+#define FRAME_NS 1000000ull          // one frame per wheel tick
+
+// Waits out the rest of the frame so both variants see the same frame times
+static void frame_pace(uint64_t frame_start)
+{
+    while (bench_now_ns() - frame_start < FRAME_NS)
+        ;
+}
+
+static size_t fires;
+
+static void on_task(CoreContext *c, void *user_data)
+{
+    (void)c; (void)user_data;
+    fires++;
+}
+
+static float task_interval(uint32_t *rng)
+{
+    *rng = *rng * 1664525u + 1013904223u;
+    return 0.25f + (float)(*rng >> 8) * (15.75f / 16777216.0f);
+}
+
+typedef struct
+{
+    const char *name;
+    float interval;
+    float elapsed;
+    ScheduledFn fn;
+    void *user_data;
+} LinearTask;
+
+// The Scheduler's update before the timing wheel: every task, every frame
+static void linear_update(LinearTask *tasks, size_t count, float delta_time)
+{
+    for (size_t i = 0; i < count; i++)
+    {
+        LinearTask *task = &tasks[i];
+        task->elapsed += delta_time;
+        if (task->elapsed >= task->interval)
+        {
+            task->fn(&ctx, task->user_data);
+            task->elapsed = 0.0f;
+        }
+    }
+}
+
+static int bench_frames(int argc, char **argv)
+{
+    static const size_t defaults[] = { 100000, 1000000 };
+    size_t runs = argc > 0 ? (size_t)argc : sizeof(defaults) / sizeof(defaults[0]);
+    int failed = 0;
+
+    printf("%10s %12s %12s %12s %14s %12s %12s\n", "tasks", "register ns", "wheel us", "wheel max us",
+           "linear walk us", "fires/frame", "cancel ns");
+    for (size_t r = 0; r < runs; ++r)
+    {
+        size_t count = argc > 0 ? strtoul(argv[r], NULL, 10) : defaults[r];
+        if (count == 0)
+        {
+            fprintf(stderr, "frames: task counts must be > 0\n");
+            return 1;
+        }
+
+        load_scheduler();
+        SchedulerHandle *handles = malloc(count * sizeof(SchedulerHandle));
+        uint32_t rng = 1;
+        uint64_t start = bench_now_ns();
+        for (size_t i = 0; i < count; ++i)
+            handles[i] = scheduler_register_fn("bench.task", task_interval(&rng), on_task, NULL);
+        double register_ns = (double)(bench_now_ns() - start) / (double)count;
+
+        size_t frames = 0;
+        uint64_t busy = 0, worst = 0;
+        fires = 0;
+        start = bench_now_ns();
+        do
+        {
+            uint64_t frame_start = bench_now_ns();
+            scheduler.api.update(&ctx);
+            uint64_t frame = bench_now_ns() - frame_start;
+            busy += frame;
+            if (frame > worst)
+                worst = frame;
+            frames++;
+            frame_pace(frame_start);
+        } while (bench_now_ns() - start < FRAMES_RUN_NS);
+        double wheel_us = (double)busy * 1e-3 / (double)frames;
+        double fires_per_frame = (double)fires / (double)frames;
+
+        size_t cancelled = 0;
+        start = bench_now_ns();
+        for (size_t i = 0; i < count; ++i)
+            cancelled += scheduler_cancel_fn(handles[i]);
+        double cancel_ns = (double)(bench_now_ns() - start) / (double)count;
+        bench_unload(&scheduler, &ctx);
+        free(handles);
+
+        // Same tasks and frame times, through the old linear walk
+        LinearTask *linear = malloc(count * sizeof(LinearTask));
+        rng = 1;
+        for (size_t i = 0; i < count; ++i)
+            linear[i] = (LinearTask){ "bench.task", task_interval(&rng), 0.0f, on_task, NULL };
+        size_t linear_frames = 0;
+        busy = 0;
+        start = bench_now_ns();
+        uint64_t last = start;
+        do
+        {
+            uint64_t frame_start = bench_now_ns();
+            linear_update(linear, count, (float)(frame_start - last) * 1e-9f);
+            last = frame_start;
+            busy += bench_now_ns() - frame_start;
+            linear_frames++;
+            frame_pace(frame_start);
+        } while (bench_now_ns() - start < FRAMES_RUN_NS);
+        double linear_us = (double)busy * 1e-3 / (double)linear_frames;
+        free(linear);
+
+        printf("%10zu %12.1f %12.2f %12.2f %14.2f %12.1f %12.1f\n", count, register_ns, wheel_us, (double)worst * 1e-3,
+               linear_us, fires_per_frame, cancel_ns);
+        if (cancelled != count)
+        {
+            printf("frames: FAILED cancelled %zu of %zu tasks\n", cancelled, count);
+            failed = 1;
+        }
+    }
+    return failed;
+}
+
+// ---------------- main ----------------
+
+static const struct
+{
+    const char *name;
+    int (*run)(int argc, char **argv);
+} modes[] = {
+    { "frames", bench_frames },
+};
+
+int main(int argc, char **argv)
+{
+    setvbuf(stdout, NULL, _IOLBF, 0);
+    for (size_t i = 0; argc > 1 && i < sizeof(modes) / sizeof(modes[0]); ++i)
+    {
+        if (strcmp(argv[1], modes[i].name) == 0)
+        {
+            bench_context(&ctx);
+            int result = modes[i].run(argc - 2, argv + 2);
+            core_context_free(&ctx);
+            return result;
+        }
+    }
+
+    fprintf(stderr, "Usage: %s <mode> [options]\nModes:", argv[0]);
+    for (size_t i = 0; i < sizeof(modes) / sizeof(modes[0]); ++i)
+        fprintf(stderr, " %s", modes[i].name);
+    fprintf(stderr, "\n");
+    return 1;
+}
@@ -0,0 +1,516 @@
+/*
+ * Benchmarks and stress tests for the Signals plugin.
+ *
+ * Usage: bench_signals <mode> [options]
+ *   emit
+ *       immediate emits per second by name and by handle with 1 to 1000 listeners
+ *   churn [max_connections]
+ *       connect and disconnect cost (random order) for growing connection counts, then
+ *       listeners that disconnect themselves and connect a replacement during every emit
+ *   senders [entities]
+ *       emit cost when each entity listens for its own events, filtering on the sender
+ *       in the callback versus connecting with signal_connect_from
+ *   deferred [producers] [per_producer]
+ *       many threads emitting deferred signals (by handle, by copied payload and by
+ *       name from a reused buffer) while the main thread flushes; checks every signal
+ *       arrives once and in per-producer order, then restarts Signals under load
+ *   parallel [listener_ns]
+ *       per-emit cost of thread-safe listeners run inline versus fanned out to the
+ *       Threads pool, for growing listener counts; THREADS_WORKERS sets the pool size
+ */
+#include "bench.h"
+#include <stdatomic.h>
+#include "../../plugins/signals/signals.h"
+#include "../../plugins/threads/threads.h"
+#include "../../external/tinycthread/source/tinycthread.h"
+
+static CoreContext ctx;
+static BenchPlugin signals;
+static BenchPlugin threads;
+
+static signal_register_fn_t signal_register_fn;
+static signal_connect_id_fn_t signal_connect_id_fn;
+static signal_emit_deferred_fn_t signal_emit_deferred_fn;
+static signal_emit_deferred_id_fn_t signal_emit_deferred_id_fn;
+static signal_emit_deferred_copy_fn_t signal_emit_deferred_copy_fn;
+static signal_emit_fn_t signal_emit_fn;
+static signal_emit_id_fn_t signal_emit_id_fn;
+static signal_connect_ex_fn_t signal_connect_ex_fn;
+static signal_connect_from_fn_t signal_connect_from_fn;
+static signal_disconnect_fn_t signal_disconnect_fn;
+static signal_set_parallel_threshold_fn_t signal_set_parallel_threshold_fn;
+
+static void load_signals(void)
+{
+    bench_load(&signals, &ctx, BENCH_PLUGIN("signals"));
+    signal_register_fn = bench_get(&ctx, CC_SIGNAL_REGISTER);
+    signal_connect_id_fn = bench_get(&ctx, CC_SIGNAL_CONNECT_ID);
+    signal_emit_deferred_fn = bench_get(&ctx, CC_SIGNAL_DEFERRED);
+    signal_emit_deferred_id_fn = bench_get(&ctx, CC_SIGNAL_DEFERRED_ID);
+    signal_emit_deferred_copy_fn = bench_get(&ctx, CC_SIGNAL_DEFERRED_COPY);
+    signal_emit_fn = bench_get(&ctx, CC_SIGNAL_EMIT);
+    signal_emit_id_fn = bench_get(&ctx, CC_SIGNAL_EMIT_ID);
+    signal_connect_ex_fn = bench_get(&ctx, CC_SIGNAL_CONNECT_EX);
+    signal_connect_from_fn = bench_get(&ctx, CC_SIGNAL_CONNECT_FROM);
+    signal_disconnect_fn = bench_get(&ctx, CC_SIGNAL_DISCONNECT);
+    signal_set_parallel_threshold_fn = bench_get(&ctx, CC_SIGNAL_SET_PARALLEL_THRESHOLD);
+}
+
+// Busy work of a fixed duration, calibrated once so listeners cost what the bench says
+static volatile uint64_t spin_sink;
+static double spin_per_ns;
+
+static void spin(uint64_t iterations)
+{
+    uint64_t x = spin_sink;
+    for (uint64_t i = 0; i < iterations; ++i)
+        x = x * 6364136223846793005ull + 1442695040888963407ull;
+    spin_sink = x;
+}
+
+static void spin_calibrate(void)
+{
+    uint64_t iterations = 1 << 20;
+    uint64_t start = bench_now_ns();
+    spin(iterations);
+    spin_per_ns = (double)iterations / (double)(bench_now_ns() - start);
+}
+
+static void bench_noop(CoreContext *c, void *sender, void *args, void *user_data)
+{
+    (void)c; (void)sender; (void)args; (void)user_data;
+}
+
+// ---------------- emit ----------------
+
+static uint64_t emit_calls;
+
+static void on_emit(CoreContext *c, void *sender, void *args, void *user_data)
+{
+    (void)c; (void)sender; (void)args; (void)user_data;
+    emit_calls++;
+}
+
+static int bench_emit(int argc, char **argv)
+{
+    (void)argc; (void)argv;
+    load_signals();
+    static const size_t counts[] = { 1, 10, 100, 1000 };
+    printf("%10s %16s %16s %18s\n", "listeners", "by name (M/s)", "by handle (M/s)", "listener calls/s (M)");
+    for (size_t c = 0; c < sizeof(counts) / sizeof(counts[0]); ++c)
+    {
+        char name[32];
+        snprintf(name, sizeof(name), "bench.emit.%zu", counts[c]);
+        SignalHandle signal = signal_register_fn(name);
+        for (size_t i = 0; i < counts[c]; ++i)
+            signal_connect_id_fn(signal, on_emit, NULL);
+
+        size_t emits = 20000000 / (counts[c] + 4);
+        emit_calls = 0;
+        uint64_t start = bench_now_ns();
+        for (size_t i = 0; i < emits; ++i)
+            signal_emit_fn(&ctx, name, NULL, NULL);
+        double by_name = (double)(bench_now_ns() - start) * 1e-9;
+        size_t named_calls = emit_calls;
+
+        emit_calls = 0;
+        start = bench_now_ns();
+        for (size_t i = 0; i < emits; ++i)
+            signal_emit_id_fn(&ctx, signal, NULL, NULL);
+        double by_handle = (double)(bench_now_ns() - start) * 1e-9;
+        if (named_calls != emits * counts[c] || emit_calls != emits * counts[c])
+        {
+            printf("emit: FAILED %zu/%llu listener calls, expected %zu\n", named_calls, (unsigned long long)emit_calls,
+                   emits * counts[c]);
+            return 1;
+        }
+        printf("%10zu %16.2f %16.2f %18.1f\n", counts[c], emits / by_name * 1e-6, emits / by_handle * 1e-6,
+               (double)emit_calls / by_handle * 1e-6);
+    }
+    bench_unload(&signals, &ctx);
+    return 0;
+}
+
+// ---------------- churn ----------------
+
+static struct
+{
+    SignalHandle signal;
+    SignalID *ids;
+    size_t calls;
+} churn;
+
+// Replaces itself with a fresh connection; the replacement must not run in this emit
+static void on_churn(CoreContext *c, void *sender, void *args, void *user_data)
+{
+    (void)c; (void)sender; (void)args;
+    size_t slot = (size_t)(uintptr_t)user_data;
+    signal_disconnect_fn(churn.ids[slot]);
+    churn.ids[slot] = signal_connect_id_fn(churn.signal, on_churn, user_data);
+    churn.calls++;
+}
+
+static int bench_churn(int argc, char **argv)
+{
+    size_t max_connections = argc > 0 ? strtoul(argv[0], NULL, 10) : 100000;
+    if (max_connections == 0)
+    {
+        fprintf(stderr, "churn: max_connections must be > 0\n");
+        return 1;
+    }
+    load_signals();
+    churn.ids = malloc(max_connections * sizeof(SignalID));
+    size_t *order = malloc(max_connections * sizeof(size_t));
+    int failed = 0;
+
+    printf("%12s %14s %17s %16s\n", "connections", "connect ns", "disconnect ns", "emit+churn ns");
+    for (size_t n = 1000; n <= max_connections; n *= 10)
+    {
+        char name[32];
+        snprintf(name, sizeof(name), "bench.churn.%zu", n);
+        churn.signal = signal_register_fn(name);
+
+        uint64_t start = bench_now_ns();
+        for (size_t i = 0; i < n; ++i)
+            churn.ids[i] = signal_connect_id_fn(churn.signal, bench_noop, NULL);
+        double connect_ns = (double)(bench_now_ns() - start) / (double)n;
+
+        // Disconnect in a random order so no implementation gets its best case
+        uint64_t rng = 0x9E3779B97F4A7C15ull ^ n;
+        for (size_t i = 0; i < n; ++i)
+            order[i] = i;
+        for (size_t i = n - 1; i > 0; --i)
+        {
+            rng = rng * 6364136223846793005ull + 1442695040888963407ull;
+            size_t j = (size_t)(rng >> 33) % (i + 1);
+            size_t t = order[i]; order[i] = order[j]; order[j] = t;
+        }
+        start = bench_now_ns();
+        for (size_t i = 0; i < n; ++i)
+            signal_disconnect_fn(churn.ids[order[i]]);
+        double disconnect_ns = (double)(bench_now_ns() - start) / (double)n;
+
+        // Every listener swaps itself out during the emit; each emit must still see exactly n
+        for (size_t i = 0; i < n; ++i)
+            churn.ids[i] = signal_connect_id_fn(churn.signal, on_churn, (void *)(uintptr_t)i);
+        size_t emits = 2000000 / n + 1;
+        churn.calls = 0;
+        start = bench_now_ns();
+        for (size_t e = 0; e < emits; ++e)
+            signal_emit_id_fn(&ctx, churn.signal, NULL, NULL);
+        double churn_ns = (double)(bench_now_ns() - start) / (double)(emits * n);
+        for (size_t i = 0; i < n; ++i)
+            signal_disconnect_fn(churn.ids[i]);
+
+        printf("%12zu %14.1f %17.1f %16.1f\n", n, connect_ns, disconnect_ns, churn_ns);
+        if (churn.calls != emits * n)
+        {
+            printf("churn: FAILED %zu listener calls, expected %zu\n", churn.calls, emits * n);
+            failed = 1;
+        }
+    }
+
+    free(order);
+    free(churn.ids);
+    bench_unload(&signals, &ctx);
+    return failed;
+}
+
+// ---------------- senders ----------------
+
+static size_t sender_hits;
+
+// Filters on the sender itself, as listeners did before signal_connect_from; with
+// connect_from the check always passes
+static void on_sender(CoreContext *c, void *sender, void *args, void *user_data)
+{
+    (void)c; (void)args;
+    if (sender == user_data)
+        sender_hits++;
+}
+
+// Emits once per entity in a scrambled order; returns ns per emit
+static double senders_emit_ns(SignalHandle signal, char *entities, size_t count, size_t rounds)
+{
+    sender_hits = 0;
+    uint64_t start = bench_now_ns();
+    for (size_t r = 0; r < rounds; ++r)
+        for (size_t i = 0; i < count; ++i)
+            signal_emit_id_fn(&ctx, signal, entities + (i * 7919 + r) % count, NULL);
+    return (double)(bench_now_ns() - start) / (double)(rounds * count);
+}
+
+static int bench_senders(int argc, char **argv)
+{
+    size_t count = argc > 0 ? strtoul(argv[0], NULL, 10) : 10000;
+    if (count == 0)
+    {
+        fprintf(stderr, "senders: entities must be > 0\n");
+        return 1;
+    }
+    load_signals();
+    char *entities = malloc(count); // only the addresses are used, as senders
+    SignalHandle filtered = signal_register_fn("bench.senders.filtered");
+    SignalHandle indexed = signal_register_fn("bench.senders.indexed");
+    for (size_t i = 0; i < count; ++i)
+    {
+        signal_connect_id_fn(filtered, on_sender, entities + i);
+        signal_connect_from_fn("bench.senders.indexed", entities + i, on_sender, entities + i);
+    }
+
+    double filtered_ns = senders_emit_ns(filtered, entities, count, 1);
+    size_t filtered_hits = sender_hits;
+    size_t rounds = 2000000 / count + 1;
+    double indexed_ns = senders_emit_ns(indexed, entities, count, rounds);
+
+    printf("senders: %zu entities, one listener each\n", count);
+    printf("%26s %14.1f ns/emit\n", "filter in callback", filtered_ns);
+    printf("%26s %14.1f ns/emit\n", "signal_connect_from", indexed_ns);
+    int failed = 0;
+    if (filtered_hits != count || sender_hits != rounds * count)
+    {
+        printf("senders: FAILED %zu/%zu matching calls, expected %zu/%zu\n", filtered_hits, sender_hits, count,
+               rounds * count);
+        failed = 1;
+    }
+    free(entities);
+    bench_unload(&signals, &ctx);
+    return failed;
+}
+
+// ---------------- deferred ----------------
+
+#define DEFERRED_MAX_PRODUCERS 64
+
+typedef struct
+{
+    uint32_t producer;
+    uint32_t seq;
+} DeferredPayload;
+
+static struct
+{
+    SignalHandle copy;
+    SignalHandle plain;
+    size_t per_producer;
+    atomic_bool stop;          // phase two: push until told to stop
+    size_t received;
+    size_t named;
+    size_t plain_received;
+    size_t out_of_order;
+    uint32_t next_seq[DEFERRED_MAX_PRODUCERS];
+} deferred;
+
+static void on_copy(CoreContext *c, void *sender, void *args, void *user_data)
+{
+    (void)c; (void)sender; (void)user_data;
+    const DeferredPayload *p = args;
+    if (p->seq != deferred.next_seq[p->producer])
+        deferred.out_of_order++;
+    deferred.next_seq[p->producer] = p->seq + 1;
+    deferred.received++;
+}
+
+static void on_named(CoreContext *c, void *sender, void *args, void *user_data)
+{
+    (void)c; (void)sender; (void)args; (void)user_data;
+    deferred.named++;
+}
+
+static void on_plain(CoreContext *c, void *sender, void *args, void *user_data)
+{
+    (void)c; (void)sender; (void)args; (void)user_data;
+    deferred.plain_received++;
+}
+
+static int deferred_producer(void *arg)
+{
+    uint32_t id = (uint32_t)(uintptr_t)arg;
+    char name[32];
+    for (uint32_t i = 0; i < deferred.per_producer || (deferred.per_producer == 0 && !atomic_load(&deferred.stop)); ++i)
+    {
+        DeferredPayload p = { id, i };
+        signal_emit_deferred_copy_fn(deferred.copy, NULL, &p, sizeof(p));
+        signal_emit_deferred_id_fn(deferred.plain, NULL, NULL);
+        if ((i & 15) == 0)
+        {
+            // The name buffer is clobbered right after the call; Signals must have copied it
+            snprintf(name, sizeof(name), "bench.named");
+            signal_emit_deferred_fn(name, NULL, NULL);
+            memset(name, 'x', sizeof(name) - 1);
+            name[sizeof(name) - 1] = '\0';
+            signal_emit_deferred_id_fn(SIGNAL_INVALID_HANDLE, NULL, NULL);
+            signal_emit_deferred_fn(NULL, NULL, NULL);
+        }
+        if (deferred.per_producer == 0)
+            thrd_yield(); // unbounded phase: leave the main thread room to restart Signals
+    }
+    return 0;
+}
+
+static void deferred_connect(void)
+{
+    deferred.copy = signal_register_fn("bench.copy");
+    deferred.plain = signal_register_fn("bench.plain");
+    signal_connect_id_fn(deferred.copy, on_copy, NULL);
+    signal_connect_id_fn(deferred.plain, on_plain, NULL);
+    signal_connect_id_fn(signal_register_fn("bench.named"), on_named, NULL);
+}
+
+static int bench_deferred(int argc, char **argv)
+{
+    int producers = argc > 0 ? atoi(argv[0]) : 8;
+    size_t per_producer = argc > 1 ? strtoul(argv[1], NULL, 10) : 200000;
+    if (producers < 1 || producers > DEFERRED_MAX_PRODUCERS || per_producer == 0)
+    {
+        fprintf(stderr, "deferred: producers must be 1..%d and per_producer > 0\n", DEFERRED_MAX_PRODUCERS);
+        return 1;
+    }
+
+    load_signals();
+    deferred_connect();
+    deferred.per_producer = per_producer;
+
+    thrd_t threads[DEFERRED_MAX_PRODUCERS];
+    size_t expected = (size_t)producers * per_producer;
+    size_t named_expected = (size_t)producers * ((per_producer + 15) / 16);
+    uint64_t start = bench_now_ns();
+    for (int i = 0; i < producers; ++i)
+        thrd_create(&threads[i], deferred_producer, (void *)(uintptr_t)i);
+
+    uint64_t frames = 0;
+    while (deferred.received < expected || deferred.named < named_expected || deferred.plain_received < expected)
+    {
+        signals.api.update(&ctx);
+        frames++;
+    }
+    double seconds = (double)(bench_now_ns() - start) * 1e-9;
+    for (int i = 0; i < producers; ++i)
+        thrd_join(threads[i], NULL);
+    signals.api.update(&ctx);
+
+    printf("deferred: %d producers x %zu signals in %.3f s over %llu flushes: %.2f M signals/s\n",
+           producers, per_producer, seconds, (unsigned long long)frames,
+           (double)(expected * 2 + named_expected) / seconds * 1e-6);
+    int failed = deferred.received != expected || deferred.plain_received != expected ||
+                 deferred.named != named_expected || deferred.out_of_order != 0;
+    if (failed)
+        printf("deferred: FAILED copy %zu/%zu plain %zu/%zu named %zu/%zu out of order %zu\n",
+               deferred.received, expected, deferred.plain_received, expected,
+               deferred.named, named_expected, deferred.out_of_order);
+
+    // Producers keep pushing while Signals shuts down and comes back (as when Threads
+    // finishes its queue after Signals is gone); nothing may touch the freed queues
+    deferred.per_producer = 0;
+    atomic_store(&deferred.stop, false);
+    for (int i = 0; i < producers; ++i)
+        thrd_create(&threads[i], deferred_producer, (void *)(uintptr_t)i);
+    for (int round = 0; round < 20; ++round)
+    {
+        signals.api.update(&ctx);
+        signals.api.shutdown(&ctx);
+        thrd_yield();
+        signals.api.init(&ctx);
+        memset(deferred.next_seq, 0, sizeof(deferred.next_seq));
+        deferred_connect();
+    }
+    atomic_store(&deferred.stop, true);
+    for (int i = 0; i < producers; ++i)
+        thrd_join(threads[i], NULL);
+    printf("deferred: restarted Signals 20 times under load\n");
+
+    bench_unload(&signals, &ctx);
+    return failed;
+}
+
+// ---------------- parallel ----------------
+
+static uint64_t parallel_listener_spin;
+
+static void on_parallel(CoreContext *c, void *sender, void *args, void *user_data)
+{
+    (void)c; (void)sender; (void)args; (void)user_data;
+    spin(parallel_listener_spin);
+}
+
+// Average microseconds per emit over enough emits to fill ~50 ms
+static double parallel_emit_us(SignalHandle signal, size_t listeners, double listener_ns)
+{
+    size_t emits = (size_t)(50e6 / (listeners * (listener_ns + 20.0))) + 20;
+    signal_emit_id_fn(&ctx, signal, NULL, NULL); // warm up the pool and the snapshot allocation
+    uint64_t start = bench_now_ns();
+    for (size_t i = 0; i < emits; ++i)
+        signal_emit_id_fn(&ctx, signal, NULL, NULL);
+    return (double)(bench_now_ns() - start) * 1e-3 / (double)emits;
+}
+
+static int bench_parallel(int argc, char **argv)
+{
+    double listener_ns = argc > 0 ? atof(argv[0]) : 1000.0;
+    bench_load(&threads, &ctx, BENCH_PLUGIN("threads"));
+    load_signals();
+    thread_worker_count_fn_t worker_count = bench_get(&ctx, CC_THREAD_WORKER_COUNT);
+
+    spin_calibrate();
+    parallel_listener_spin = (uint64_t)(listener_ns * spin_per_ns);
+    SignalHandle signal = signal_register_fn("bench.parallel");
+
+    printf("parallel: %d pool workers, listeners of %.0f ns\n", worker_count(), listener_ns);
+    printf("%10s %14s %14s %10s\n", "listeners", "inline us", "parallel us", "speedup");
+    size_t connected = 0;
+    SignalID ids[8192];
+    for (size_t listeners = 4; listeners <= 8192; listeners *= 2)
+    {
+        for (; connected < listeners; ++connected)
+        {
+            SignalConnectDesc desc = { .handle = signal, .callback = on_parallel, .flags = SIGNAL_CONNECT_THREAD_SAFE };
+            ids[connected] = signal_connect_ex_fn(&desc);
+        }
+        signal_set_parallel_threshold_fn(0);
+        double inline_us = parallel_emit_us(signal, listeners, listener_ns);
+        signal_set_parallel_threshold_fn(1);
+        double parallel_us = parallel_emit_us(signal, listeners, listener_ns);
+        printf("%10zu %14.2f %14.2f %9.2fx\n", listeners, inline_us, parallel_us, inline_us / parallel_us);
+    }
+    for (size_t i = 0; i < connected; ++i)
+        signal_disconnect_fn(ids[i]);
+
+    bench_unload(&signals, &ctx);
+    bench_unload(&threads, &ctx);
+    return 0;
+}
+
+// ---------------- main ----------------
+
+static const struct
+{
+    const char *name;
+    int (*run)(int argc, char **argv);
+} modes[] = {
+    { "emit", bench_emit },
+    { "churn", bench_churn },
+    { "senders", bench_senders },
+    { "deferred", bench_deferred },
+    { "parallel", bench_parallel },
+};
+
+int main(int argc, char **argv)
+{
+    setvbuf(stdout, NULL, _IOLBF, 0);
+    for (size_t i = 0; argc > 1 && i < sizeof(modes) / sizeof(modes[0]); ++i)
+    {
+        if (strcmp(argv[1], modes[i].name) == 0)
+        {
+            bench_context(&ctx);
+            int result = modes[i].run(argc - 2, argv + 2);
+            core_context_free(&ctx);
+            return result;
+        }
+    }
+
+    fprintf(stderr, "Usage: %s <mode> [options]\nModes:", argv[0]);
+    for (size_t i = 0; i < sizeof(modes) / sizeof(modes[0]); ++i)
+        fprintf(stderr, " %s", modes[i].name);
+    fprintf(stderr, "\n");
+    return 1;
+}
@@ -0,0 +1,298 @@
+/*
+ * Benchmarks for the Threads plugin.
+ *
+ * Usage: bench_threads <mode> [options]
+ *   jobs [job_ns]
+ *       jobs per second through the worker pool versus one thread created and joined per
+ *       job, as Threads did before the pool; jobs are batched 64 at a time
+ *   scaling [max_workers] [elements]
+ *       parallel_for, parallel_reduce and radix_sort32 times for 1..max_workers pool
+ *       workers (default: the core count), restarting Threads with THREADS_WORKERS
+ */
+#include "bench.h"
+#include <stdatomic.h>
+#include "../../plugins/threads/threads.h"
+#include "../../external/tinycthread/source/tinycthread.h"
+
+static CoreContext ctx;
+static BenchPlugin threads;
+
+static thread_spawn_fn_t thread_spawn_fn;
+static thread_job_wait_fn_t thread_job_wait_fn;
+static thread_worker_count_fn_t thread_worker_count_fn;
+static thread_parallel_for_fn_t thread_parallel_for_fn;
+static thread_parallel_reduce_fn_t thread_parallel_reduce_fn;
+static thread_radix_sort32_fn_t thread_radix_sort32_fn;
+
+static void load_threads(void)
+{
+    bench_load(&threads, &ctx, BENCH_PLUGIN("threads"));
+    thread_spawn_fn = bench_get(&ctx, CC_THREAD_SPAWN);
+    thread_job_wait_fn = bench_get(&ctx, CC_THREAD_JOB_WAIT);
+    thread_worker_count_fn = bench_get(&ctx, CC_THREAD_WORKER_COUNT);
+    thread_parallel_for_fn = bench_get(&ctx, CC_THREAD_PARALLEL_FOR);
+    thread_parallel_reduce_fn = bench_get(&ctx, CC_THREAD_PARALLEL_REDUCE);
+    thread_radix_sort32_fn = bench_get(&ctx, CC_THREAD_RADIX_SORT32);
+}
+
+// Reloads Threads with a pool of `workers` threads
+static void reload_threads(int workers)
+{
+    char value[16];
+    snprintf(value, sizeof(value), "%d", workers);
+#ifdef _WIN32
+    _putenv_s("THREADS_WORKERS", value);
+#else
+    setenv("THREADS_WORKERS", value, 1);
+#endif
+    bench_unload(&threads, &ctx);
+    load_threads();
+}
+
+// Busy work of a fixed duration, calibrated once so jobs cost what the bench says
+static volatile uint64_t spin_sink;
+static double spin_per_ns;
+
+static void spin(uint64_t iterations)
+{
+    uint64_t x = spin_sink;
+    for (uint64_t i = 0; i < iterations; ++i)
+        x = x * 6364136223846793005ull + 1442695040888963407ull;
+    spin_sink = x;
+}
+
+static void spin_calibrate(void)
+{
+    uint64_t iterations = 1 << 20;
+    uint64_t start = bench_now_ns();
+    spin(iterations);
+    spin_per_ns = (double)iterations / (double)(bench_now_ns() - start);
+}
+
+// ---------------- jobs ----------------
+
+#define JOBS_BATCH 64
+#define JOBS_RUN_NS 250000000ull // each variant runs whole batches for about this long
+
+static uint64_t job_spin;
+static atomic_size_t jobs_run;
+
+static int bench_job(void *user_data)
+{
+    (void)user_data;
+    spin(job_spin);
+    atomic_fetch_add_explicit(&jobs_run, 1, memory_order_relaxed);
+    return 0;
+}
+
+// The pre-pool implementation: a fresh thread per job, joined once it finishes
+static double jobs_per_thread(size_t *jobs)
+{
+    thrd_t handles[JOBS_BATCH];
+    uint64_t start = bench_now_ns(), elapsed;
+    *jobs = 0;
+    do
+    {
+        for (int i = 0; i < JOBS_BATCH; ++i)
+            thrd_create(&handles[i], bench_job, NULL);
+        for (int i = 0; i < JOBS_BATCH; ++i)
+            thrd_join(handles[i], NULL);
+        *jobs += JOBS_BATCH;
+        elapsed = bench_now_ns() - start;
+    } while (elapsed < JOBS_RUN_NS);
+    return (double)*jobs / ((double)elapsed * 1e-9);
+}
+
+static double jobs_pool(size_t *jobs)
+{
+    JobHandle handles[JOBS_BATCH];
+    uint64_t start = bench_now_ns(), elapsed;
+    *jobs = 0;
+    do
+    {
+        for (int i = 0; i < JOBS_BATCH; ++i)
+            handles[i] = thread_spawn_fn(bench_job, NULL);
+        for (int i = 0; i < JOBS_BATCH; ++i)
+            thread_job_wait_fn(handles[i], NULL);
+        *jobs += JOBS_BATCH;
+        elapsed = bench_now_ns() - start;
+    } while (elapsed < JOBS_RUN_NS);
+    return (double)*jobs / ((double)elapsed * 1e-9);
+}
+
+static int bench_jobs(int argc, char **argv)
+{
+    double job_ns = argc > 0 ? atof(argv[0]) : 0.0;
+    load_threads();
+    spin_calibrate();
+    job_spin = (uint64_t)(job_ns * spin_per_ns);
+
+    size_t per_thread_jobs, pool_jobs;
+    atomic_store(&jobs_run, 0);
+    double per_thread = jobs_per_thread(&per_thread_jobs);
+    double pool = jobs_pool(&pool_jobs);
+
+    printf("jobs: %d pool workers, jobs of %.0f ns\n", thread_worker_count_fn(), job_ns);
+    printf("%22s %14.0f jobs/s\n", "thread per job", per_thread);
+    printf("%22s %14.0f jobs/s  (%.1fx)\n", "worker pool", pool, pool / per_thread);
+    int failed = 0;
+    if (atomic_load(&jobs_run) != per_thread_jobs + pool_jobs)
+    {
+        printf("jobs: FAILED %zu jobs ran, expected %zu\n", atomic_load(&jobs_run), per_thread_jobs + pool_jobs);
+        failed = 1;
+    }
+    bench_unload(&threads, &ctx);
+    return failed;
+}
+
+// ---------------- scaling ----------------
+
+static struct
+{
+    uint32_t *source;
+    uint32_t *keys;
+    float *values;
+} scaling;
+
+// A few dependent multiplies per element so the loop is compute bound, not memory bound
+static void scaling_for(size_t begin, size_t end, void *user_data)
+{
+    (void)user_data;
+    for (size_t i = begin; i < end; ++i)
+    {
+        uint32_t x = scaling.source[i];
+        for (int k = 0; k < 16; ++k)
+            x = x * 1664525u + 1013904223u;
+        scaling.values[i] = (float)(x >> 8) * (1.0f / 16777216.0f);
+    }
+}
+
+static void scaling_reduce(size_t begin, size_t end, void *acc, void *user_data)
+{
+    (void)user_data;
+    double sum = *(double *)acc;
+    for (size_t i = begin; i < end; ++i)
+        sum += scaling.values[i];
+    *(double *)acc = sum;
+}
+
+static void scaling_combine(void *acc, const void *value, void *user_data)
+{
+    (void)user_data;
+    *(double *)acc += *(const double *)value;
+}
+
+// Best of three, in milliseconds; the first run also warms up the pool
+#define SCALING_TIME(ms, setup, call)                         \
+    do                                                        \
+    {                                                         \
+        ms = 1e30;                                            \
+        for (int run = 0; run < 3; ++run)                     \
+        {                                                     \
+            setup;                                            \
+            uint64_t start = bench_now_ns();                  \
+            call;                                             \
+            double t = (double)(bench_now_ns() - start) * 1e-6; \
+            if (t < ms)                                       \
+                ms = t;                                       \
+        }                                                     \
+    } while (0)
+
+static int bench_scaling(int argc, char **argv)
+{
+    load_threads();
+    int max_workers = argc > 0 ? atoi(argv[0]) : thread_worker_count_fn();
+    size_t count = argc > 1 ? strtoul(argv[1], NULL, 10) : (size_t)1 << 22;
+    if (max_workers < 1 || count == 0)
+    {
+        fprintf(stderr, "scaling: max_workers and elements must be > 0\n");
+        return 1;
+    }
+    scaling.source = malloc(count * sizeof(uint32_t));
+    scaling.keys = malloc(count * sizeof(uint32_t));
+    scaling.values = malloc(count * sizeof(float));
+    uint32_t rng = 12345;
+    for (size_t i = 0; i < count; ++i)
+    {
+        rng = rng * 1664525u + 1013904223u;
+        scaling.source[i] = rng;
+    }
+
+    printf("scaling: %zu elements, best of 3\n", count);
+    printf("%8s %14s %14s %14s %10s\n", "workers", "for ms", "reduce ms", "sort ms", "speedup");
+    double base = 0.0, first_sum = 0.0;
+    int failed = 0;
+    for (int workers = 1; workers <= max_workers; ++workers)
+    {
+        reload_threads(workers);
+        double for_ms, reduce_ms, sort_ms, sum = 0.0;
+        const double zero = 0.0;
+        SCALING_TIME(for_ms, (void)0, thread_parallel_for_fn(0, count, 0, scaling_for, NULL));
+        SCALING_TIME(reduce_ms, (void)0,
+                     thread_parallel_reduce_fn(0, count, 0, sizeof(double), &zero, scaling_reduce, scaling_combine, &sum, NULL));
+        SCALING_TIME(sort_ms, memcpy(scaling.keys, scaling.source, count * sizeof(uint32_t)),
+                     thread_radix_sort32_fn(scaling.keys, NULL, count));
+
+        double total = for_ms + reduce_ms + sort_ms;
+        if (workers == 1)
+        {
+            base = total;
+            first_sum = sum;
+        }
+        printf("%8d %14.2f %14.2f %14.2f %9.2fx\n", workers, for_ms, reduce_ms, sort_ms, base / total);
+
+        for (size_t i = 1; i < count; ++i)
+        {
+            if (scaling.keys[i - 1] > scaling.keys[i])
+            {
+                printf("scaling: FAILED keys out of order at %zu\n", i);
+                failed = 1;
+                break;
+            }
+        }
+        // The chunk count follows the worker count, so sums may differ in the last bits
+        if (sum < first_sum * 0.999999 || sum > first_sum * 1.000001)
+        {
+            printf("scaling: FAILED sum %f, expected %f\n", sum, first_sum);
+            failed = 1;
+        }
+    }
+
+    free(scaling.source);
+    free(scaling.keys);
+    free(scaling.values);
+    bench_unload(&threads, &ctx);
+    return failed;
+}
+
+// ---------------- main ----------------
+
+static const struct
+{
+    const char *name;
+    int (*run)(int argc, char **argv);
+} modes[] = {
+    { "jobs", bench_jobs },
+    { "scaling", bench_scaling },
+};
+
+int main(int argc, char **argv)
+{
+    setvbuf(stdout, NULL, _IOLBF, 0);
+    for (size_t i = 0; argc > 1 && i < sizeof(modes) / sizeof(modes[0]); ++i)
+    {
+        if (strcmp(argv[1], modes[i].name) == 0)
+        {
+            bench_context(&ctx);
+            int result = modes[i].run(argc - 2, argv + 2);
+            core_context_free(&ctx);
+            return result;
+        }
+    }
+
+    fprintf(stderr, "Usage: %s <mode> [options]\nModes:", argv[0]);
+    for (size_t i = 0; i < sizeof(modes) / sizeof(modes[0]); ++i)
+        fprintf(stderr, " %s", modes[i].name);
+    fprintf(stderr, "\n");
+    return 1;
+}
@@ -0,0 +1,283 @@
+/*
+ * Decodes binary logs written with CORE_LOG_FORMAT=binary back into the text
+ * format produced by logger().
+ *
+ * Usage: log_decode [-s] <file.blog>
+ *        log_decode --ring <file.ring>
+ *   -s      include the source (plugin) name after the level prefix
+ *   --ring  dump a CORE_LOG_RING_MB ring file (e.g. logs/core.ring after a crash), oldest first
+ */
+#include "../../include/logger.h"
+#include "../../include/log_ring.h"
+#include <stdlib.h>
+#include <string.h>
+#include <stddef.h>
+#include <time.h>
+#include <locale.h>
+#include <wchar.h>
+
+typedef struct
+{
+    char** data;
+    size_t capacity;
+} StringTable;
+
+static void table_set(StringTable* t, uint32_t id, char* str)
+{
+    if (id >= t->capacity)
+    {
+        size_t new_capacity = t->capacity ? t->capacity : 64;
+        while (new_capacity <= id)
+            new_capacity *= 2;
+        t->data = realloc(t->data, new_capacity * sizeof(char*));
+        memset(t->data + t->capacity, 0, (new_capacity - t->capacity) * sizeof(char*));
+        t->capacity = new_capacity;
+    }
+    free(t->data[id]);
+    t->data[id] = str;
+}
+
+static const char* table_get(const StringTable* t, uint32_t id)
+{
+    return id < t->capacity ? t->data[id] : NULL;
+}
+
+static void table_free(StringTable* t)
+{
+    for (size_t i = 0; i < t->capacity; ++i)
+        free(t->data[i]);
+    free(t->data);
+}
+
+static int read_i64(const unsigned char** p, const unsigned char* end, int64_t* out)
+{
+    if (end - *p < 8)
+        return 0;
+    memcpy(out, *p, 8);
+    *p += 8;
+    return 1;
+}
+
+/* Formats a single conversion specification with its recorded arguments. */
+static void print_spec(FILE* out, const LogFormatSpec* spec, const unsigned char** p, const unsigned char* end)
+{
+    char fmt[64];
+    size_t len = spec->len < sizeof(fmt) - 1 ? spec->len : sizeof(fmt) - 1;
+    memcpy(fmt, spec->start, len);
+    fmt[len] = '\0';
+
+    int stars[2] = {0, 0};
+    for (int i = 0; i < spec->stars && i < 2; ++i)
+    {
+        int64_t v;
+        if (!read_i64(p, end, &v))
+            return;
+        stars[i] = (int)v;
+    }
+
+#define EMIT(value) \
+    do { \
+        if (spec->stars == 0) fprintf(out, fmt, value); \
+        else if (spec->stars == 1) fprintf(out, fmt, stars[0], value); \
+        else fprintf(out, fmt, stars[0], stars[1], value); \
+    } while (0)
+
+    int64_t iv;
+    double dv;
+    switch (spec->type)
+    {
+        case LA_NONE:
+            if (spec->len == 2 && spec->start[1] == '%')
+                fputc('%', out);
+            return;
+        case LA_INT:     if (read_i64(p, end, &iv)) EMIT((int)iv); return;
+        case LA_LONG:    if (read_i64(p, end, &iv)) EMIT((long)iv); return;
+        case LA_LLONG:   if (read_i64(p, end, &iv)) EMIT((long long)iv); return;
+        case LA_SIZE:    if (read_i64(p, end, &iv)) EMIT((size_t)iv); return;
+        case LA_INTMAX:  if (read_i64(p, end, &iv)) EMIT((intmax_t)iv); return;
+        case LA_PTRDIFF: if (read_i64(p, end, &iv)) EMIT((ptrdiff_t)iv); return;
+        case LA_POINTER: if (read_i64(p, end, &iv)) EMIT((void*)(uintptr_t)iv); return;
+        case LA_WCHAR:   if (read_i64(p, end, &iv)) EMIT((wint_t)iv); return;
+        case LA_DOUBLE:
+            if (read_i64(p, end, &iv)) { memcpy(&dv, &iv, sizeof(dv)); EMIT(dv); }
+            return;
+        case LA_LDOUBLE:
+            if (read_i64(p, end, &iv)) { memcpy(&dv, &iv, sizeof(dv)); EMIT((long double)dv); }
+            return;
+        case LA_STRING:
+        {
+            uint32_t slen;
+            if (end - *p < (ptrdiff_t)sizeof(slen))
+                return;
+            memcpy(&slen, *p, sizeof(slen));
+            *p += sizeof(slen);
+            if ((size_t)(end - *p) < slen)
+                slen = (uint32_t)(end - *p);
+            char* str = malloc(slen + 1);
+            memcpy(str, *p, slen);
+            str[slen] = '\0';
+            *p += slen;
+            EMIT(str);
+            free(str);
+            return;
+        }
+        case LA_WSTRING:
+        {
+            uint32_t slen;
+            if (end - *p < (ptrdiff_t)sizeof(slen))
+                return;
+            memcpy(&slen, *p, sizeof(slen));
+            *p += sizeof(slen);
+            if ((size_t)(end - *p) / sizeof(uint32_t) < slen)
+                slen = (uint32_t)((size_t)(end - *p) / sizeof(uint32_t));
+            wchar_t* str = malloc((slen + 1) * sizeof(wchar_t));
+            for (uint32_t i = 0; i < slen; ++i)
+            {
+                uint32_t ch;
+                memcpy(&ch, *p, sizeof(ch));
+                *p += sizeof(ch);
+                str[i] = (wchar_t)ch;
+            }
+            str[slen] = L'\0';
+            EMIT(str);
+            free(str);
+            return;
+        }
+    }
+#undef EMIT
+}
+
+static void print_message(FILE* out, const LogRecordHeader* h, const char* fmt, const char* source,
+                          const unsigned char* payload)
+{
+    const char* prefix = "";
+    switch ((LogLevel)h->level)
+    {
+        case LL_INFO:  prefix = "[INFO]";  break;
+        case LL_WARN:  prefix = "[WARN]";  break;
+        case LL_ERROR: prefix = "[ERROR]"; break;
+        case LL_DEBUG: prefix = "[DEBUG]"; break;
+    }
+
+    time_t seconds = (time_t)(h->timestamp_ns / 1000000000ull);
+    struct tm* t = localtime(&seconds);
+    char time_buf[20];
+    strftime(time_buf, sizeof(time_buf), "%Y-%m-%d %H:%M:%S", t);
+
+    if (source)
+        fprintf(out, "[%s] %s [%s] ", time_buf, prefix, source);
+    else
+        fprintf(out, "[%s] %s ", time_buf, prefix);
+
+    if (!fmt)
+    {
+        fprintf(out, "<unknown format %u>\n", h->id);
+        return;
+    }
+
+    const unsigned char* p = payload;
+    const unsigned char* end = payload + h->size;
+    const char* cursor = fmt;
+    LogFormatSpec spec;
+    const char* next;
+    while ((next = log_format_next(cursor, &spec)))
+    {
+        fwrite(cursor, 1, (size_t)(spec.start - cursor), out);
+        print_spec(out, &spec, &p, end);
+        cursor = next;
+    }
+    fputs(cursor, out);
+    fputc('\n', out);
+}
+
+int main(int argc, char** argv)
+{
+    int show_source = 0;
+    int ring = 0;
+    const char* path = NULL;
+    for (int i = 1; i < argc; ++i)
+    {
+        if (strcmp(argv[i], "-s") == 0)
+            show_source = 1;
+        else if (strcmp(argv[i], "--ring") == 0)
+            ring = 1;
+        else
+            path = argv[i];
+    }
+    setlocale(LC_CTYPE, ""); // so %ls and %lc arguments convert to the terminal's encoding
+
+    if (!path)
+    {
+        fprintf(stderr, "Usage: %s [-s] <file.blog>\n       %s --ring <file.ring>\n", argv[0], argv[0]);
+        return 1;
+    }
+
+    if (ring)
+    {
+        if (log_ring_dump(path, stdout) != 0)
+        {
+            fprintf(stderr, "%s: not a log ring file\n", path);
+            return 1;
+        }
+        return 0;
+    }
+
+    FILE* in = fopen(path, "rb");
+    if (!in)
+    {
+        perror("fopen");
+        return 1;
+    }
+
+    LogBinaryFileHeader header;
+    if (fread(&header, sizeof(header), 1, in) != 1 || header.magic != LOG_BINARY_MAGIC)
+    {
+        fprintf(stderr, "%s: not a binary log file\n", path);
+        fclose(in);
+        return 1;
+    }
+    if (header.version != LOG_BINARY_VERSION || header.record_header_size != sizeof(LogRecordHeader))
+    {
+        fprintf(stderr, "%s: unsupported log version %u\n", path, header.version);
+        fclose(in);
+        return 1;
+    }
+
+    StringTable formats = {0};
+    StringTable sources = {0};
+    LogRecordHeader h;
+    while (fread(&h, sizeof(h), 1, in) == 1)
+    {
+        unsigned char* payload = malloc(h.size + 1);
+        if (!payload || fread(payload, 1, h.size, in) != h.size)
+        {
+            fprintf(stderr, "%s: truncated record\n", path);
+            free(payload);
+            break;
+        }
+        payload[h.size] = '\0';
+
+        switch (h.kind)
+        {
+            case LR_FORMAT:
+                table_set(&formats, h.id, (char*)payload);
+                continue;
+            case LR_SOURCE:
+                table_set(&sources, h.id, (char*)payload);
+                continue;
+            case LR_MESSAGE:
+                print_message(stdout, &h, table_get(&formats, h.id),
+                              show_source ? table_get(&sources, h.source) : NULL, payload);
+                break;
+            default:
+                fprintf(stderr, "%s: unknown record kind %u\n", path, h.kind);
+                break;
+        }
+        free(payload);
+    }
+
+    table_free(&formats);
+    table_free(&sources);
+    fclose(in);
+    return 0;
+}
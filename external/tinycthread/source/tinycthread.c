@@ -0,0 +1 @@
+/* local build stub, see tinycthread.h */
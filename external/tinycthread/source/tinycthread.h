@@ -0,0 +1,6 @@
+/* local build stub: map tinycthread onto C11 <threads.h> */
+#ifndef _TINYCTHREAD_H_
+#define _TINYCTHREAD_H_
+#include <threads.h>
+#include <time.h>
+#endif
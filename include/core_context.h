@@ -51,6 +51,60 @@
   */
  #define CC_BIND(ctx,string,data,size,owned) \
      (ctx)->memory.bind(&(ctx)->memory.map,LIT(string),data,size,owned)
+
+ /**
+  * @def CC_LOG_ENABLED
+  * @brief Nonzero unless `level` is below the threshold of every log source (see logger_level_floor()).
+  */
+ #define CC_LOG_ENABLED(ctx,level) \
+     ((level) >= atomic_load_explicit((ctx)->log_level_floor, memory_order_relaxed))
+
+ /**
+  * @def CC_LOG
+  * @brief Logs through the CoreContext if `level` is enabled for the calling thread's source.
+  *
+  * Levels below every source's threshold are dropped before the arguments are evaluated, for one
+  * load and one branch; the rest are filtered by logger() against the calling thread's source,
+  * so worker threads are not affected by which plugin the main thread is running.
+  */
+ #define CC_LOG(ctx,level,...) \
+     do { if ((level) >= LOG_COMPILE_LEVEL && CC_LOG_ENABLED(ctx, level)) (ctx)->log((level), __VA_ARGS__); } while (0)
+
+ /**
+  * @def CC_LOG_RATELIMITED
+  * @brief Like CC_LOG, but each call site may log at most `per_second` messages per second
+  *        (bursts up to `burst`). Repeats are collapsed into a "N similar messages suppressed" line.
+  */
+ #define CC_LOG_RATELIMITED(ctx,level,per_second,burst,...) \
+     do { \
+         static LogRateLimit _cc_log_limit = LOG_RATE_LIMIT_INIT(per_second, burst); \
+         if ((level) >= LOG_COMPILE_LEVEL && CC_LOG_ENABLED(ctx, level)) \
+             (ctx)->log_limited(&_cc_log_limit, (level), __VA_ARGS__); \
+     } while (0)
+
+ /**
+  * @def CC_LOG_DEBUG
+  * @brief CC_LOG at LL_DEBUG. The CC_LOG_<LEVEL> macros compile to nothing below LOG_COMPILE_LEVEL.
+  */
+ #if LOG_COMPILE_LEVEL <= LOG_LEVEL_DEBUG
+ #define CC_LOG_DEBUG(ctx,...) CC_LOG(ctx, LL_DEBUG, __VA_ARGS__)
+ #else
+ #define CC_LOG_DEBUG(ctx,...) ((void)0)
+ #endif
+
+ #if LOG_COMPILE_LEVEL <= LOG_LEVEL_INFO
+ #define CC_LOG_INFO(ctx,...) CC_LOG(ctx, LL_INFO, __VA_ARGS__)
+ #else
+ #define CC_LOG_INFO(ctx,...) ((void)0)
+ #endif
+
+ #if LOG_COMPILE_LEVEL <= LOG_LEVEL_WARN
+ #define CC_LOG_WARN(ctx,...) CC_LOG(ctx, LL_WARN, __VA_ARGS__)
+ #else
+ #define CC_LOG_WARN(ctx,...) ((void)0)
+ #endif
+
+ #define CC_LOG_ERROR(ctx,...) CC_LOG(ctx, LL_ERROR, __VA_ARGS__)
  
  /**
   * @brief The shared context passed to all plugins.
@@ -91,6 +145,21 @@
       * 
       */
      void (*log)(enum LogLevel level, const char* fmt, ...);
+
+     /**
+      * @brief Logs through a per-call-site rate limit (see CC_LOG_RATELIMITED).
+      */
+     void (*log_limited)(LogRateLimit* limit, enum LogLevel level, const char* fmt, ...);
+
+     /**
+      * @brief Lowest level enabled for any log source (see CC_LOG and logger_level_floor()).
+      */
+     const _Atomic(LogLevel)* log_level_floor;
+
+     /**
+      * @brief Sets the runtime log level of a plugin by name, or of every plugin when NULL.
+      */
+     void (*log_set_level)(const char* plugin, LogLevel level);
  
      float delta_time;        /**< Time in seconds since the last frame. */
      float fixed_delta_time;  /**< Fixed time step, if used (optional). */
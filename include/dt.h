@@ -23,6 +23,13 @@
   * @return A float representing the elapsed time in seconds.
   */
  float get_dt(void);
+
+ /**
+  * @brief Reads a monotonic clock, for measuring intervals.
+  *
+  * @return Nanoseconds since an arbitrary fixed point.
+  */
+ unsigned long long dt_now_ns(void);
  
  #endif /* _COMMON_H */
  
\ No newline at end of file
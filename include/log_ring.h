@@ -0,0 +1,110 @@
+/**
+ * @file log_ring.h
+ * @brief Crash-safe, size-bounded log sink backed by a memory-mapped ring file.
+ *
+ * Log lines are copied straight into a shared file mapping, so the hot path makes no
+ * `write` syscalls and the kernel still flushes everything written before a crash.
+ * When the ring is full it either wraps (keeping the most recent bytes) or, if archives
+ * are enabled, rotates its contents into plain text archives `<path>.1.log` ... `<path>.N.log`.
+ * A rotation only copies the ring into memory; the archive files are written later by
+ * log_ring_archive(), so writers never wait on file I/O.
+ *
+ * The mapping is mmap on POSIX and CreateFileMapping/MapViewOfFile on Windows. A LogRing is not
+ * thread-safe; the logger only writes to it while holding its own lock.
+ */
+
+ #ifndef _LOG_RING_H
+ #define _LOG_RING_H
+
+ #include <stddef.h>
+ #include <stdint.h>
+ #include <stdio.h>
+ #include <stdatomic.h>
+
+ #define LOG_RING_MAGIC   0x474E5250u /* "PRNG" */
+ #define LOG_RING_VERSION 1
+
+ /**
+  * @brief Header stored in the first page of the ring file.
+  */
+ typedef struct LogRingHeader
+ {
+     uint32_t magic;     /**< LOG_RING_MAGIC. */
+     uint32_t version;   /**< LOG_RING_VERSION. */
+     uint64_t capacity;  /**< Size of the data region in bytes. */
+     uint64_t written;   /**< Total bytes written since the ring was last reset. */
+ } LogRingHeader;
+
+ /**
+  * @brief An open ring file.
+  */
+ typedef struct LogRing
+ {
+     intptr_t file;          /**< File descriptor (HANDLE on Windows) of the ring file, -1 when closed. */
+     void* mapping;          /**< File mapping object on Windows; unused elsewhere. */
+     unsigned char* map;     /**< Start of the mapping (header page followed by data). */
+     size_t map_size;        /**< Size of the mapping in bytes. */
+     LogRingHeader* header;  /**< Header inside the mapping. */
+     unsigned char* data;    /**< Data region inside the mapping. */
+     int max_archives;       /**< Number of rotated archives to keep; 0 wraps instead. */
+     unsigned char* archive; /**< Contents of the last rotation, oldest first, until it is archived. */
+     size_t archive_size;    /**< Bytes in `archive`. */
+     atomic_int archive_pending; /**< Set by log_ring_write() when `archive` is waiting for log_ring_archive(). */
+     char path[256];         /**< Path of the ring file. */
+ } LogRing;
+
+ /**
+  * @brief Opens (or creates) a ring file of the given data capacity.
+  *
+  * An existing ring with the same capacity is continued; otherwise it is archived (when
+  * archives are enabled) and reset.
+  *
+  * @param ring          Ring to initialize.
+  * @param path          Path of the ring file.
+  * @param capacity      Size of the data region in bytes.
+  * @param max_archives  Rotated archives to keep, or 0 to wrap in place.
+  * @return 0 on success, non-zero on failure.
+  */
+ int log_ring_open(LogRing* ring, const char* path, size_t capacity, int max_archives);
+
+ /**
+  * @brief Appends bytes to the ring, wrapping or rotating when it is full.
+  *
+  * A rotation copies the ring into memory and leaves the archive to log_ring_archive(). If the
+  * previous rotation has not been archived yet, the ring wraps instead, overwriting its oldest bytes.
+  *
+  * Not thread-safe: callers writing from several threads must serialize the calls.
+  */
+ void log_ring_write(LogRing* ring, const char* data, size_t len);
+
+ /**
+  * @brief Writes a pending rotation to `<path>.1.log`, shifting older archives up.
+  *
+  * Does nothing when no rotation is pending. It only reads the rotated copy, which writers leave
+  * alone until this returns, so it may run while another thread calls log_ring_write(); calls
+  * to log_ring_archive() itself must come from one thread (the logger uses the main thread).
+  */
+ void log_ring_archive(LogRing* ring);
+
+ /**
+  * @brief Copies the ring contents, oldest first, into a plain file.
+  *
+  * @return 0 on success, non-zero on failure.
+  */
+ int log_ring_export(const LogRing* ring, const char* path);
+
+ /**
+  * @brief Reads a ring file without mapping or modifying it and writes its contents, oldest first.
+  *
+  * Meant for recovering the log of a crashed process (see `log_decode --ring`).
+  *
+  * @return 0 on success, non-zero if the file is missing or not a ring.
+  */
+ int log_ring_dump(const char* path, FILE* out);
+
+ /**
+  * @brief Unmaps and closes the ring file.
+  */
+ void log_ring_close(LogRing* ring);
+
+ #endif /* _LOG_RING_H */
@@ -2,21 +2,210 @@
 #define _CORE_LOGGER_H
 
 #include <stdio.h>
+#include <stdint.h>
+#include <stdatomic.h>
 
+#define LOG_LEVEL_DEBUG 0
+#define LOG_LEVEL_INFO  1
+#define LOG_LEVEL_WARN  2
+#define LOG_LEVEL_ERROR 3
+
+/**
+ * @def LOG_COMPILE_LEVEL
+ * @brief Lowest level compiled into the CC_LOG_* macros (e.g. `-DLOG_COMPILE_LEVEL=LOG_LEVEL_INFO`).
+ */
+#ifndef LOG_COMPILE_LEVEL
+#define LOG_COMPILE_LEVEL LOG_LEVEL_DEBUG
+#endif
+
+/* Ordered by severity so that filtering is a single comparison. */
 typedef enum LogLevel
 {
-    LL_INFO,
-    LL_WARN,
-    LL_ERROR,
-    LL_DEBUG,
+    LL_DEBUG = LOG_LEVEL_DEBUG,
+    LL_INFO = LOG_LEVEL_INFO,
+    LL_WARN = LOG_LEVEL_WARN,
+    LL_ERROR = LOG_LEVEL_ERROR,
 } LogLevel;
 
+/**
+ * @brief Opens the log sink under `logs/`.
+ *
+ * Setting the environment variable `CORE_LOG_FORMAT=binary` switches the file sink to the
+ * binary deferred-formatting format (`logs/<timestamp>.blog`). In that mode only warnings and
+ * errors are formatted to stderr; everything else is recorded raw and decoded offline with
+ * `build/log_decode`.
+ *
+ * `CORE_LOG_RING_MB=N` replaces the per-run text file with the crash-safe mmap ring
+ * `logs/core.ring` holding the last N MB (see log_ring.h); `CORE_LOG_ARCHIVES=K` rotates a full
+ * ring into `logs/core.ring.1.log` ... `.K.log` instead of wrapping (written by logger_update()).
+ *
+ * `CORE_LOG_LEVEL` sets the runtime thresholds, e.g. `CORE_LOG_LEVEL=info,Signals=debug`
+ * (a bare level is the default, `Name=level` overrides one source).
+ */
 void logger_init();
 
 void logger_shutdown();
 
+/**
+ * @brief Reports rate-limited messages that have been suppressed for over a second, and
+ *        writes the archive of a log ring that rotated since the last call.
+ *
+ * Called once per frame by the core loop, on the main thread.
+ */
+void logger_update();
+
 void logger(enum LogLevel level, const char* fmt, ...);
 
 typedef void (*logger_fn_t)(enum LogLevel level, const char* fmt, ...);
 
-#endif /*_CORE_LOGGER_H*/
\ No newline at end of file
+/**
+ * @brief Per-call-site token bucket used by logger_ratelimited().
+ */
+typedef struct LogRateLimit
+{
+    float rate;           /**< Messages allowed per second on average. */
+    float burst;          /**< Messages allowed back to back before limiting starts. */
+    float tokens;         /**< Messages currently available. */
+    uint64_t last_ns;     /**< Time of the last refill (0 = never used). */
+} LogRateLimit;
+
+/**
+ * @def LOG_RATE_LIMIT_INIT
+ * @brief Static initializer for a LogRateLimit.
+ */
+#define LOG_RATE_LIMIT_INIT(per_second, burst) { (per_second), (burst), 0.0f, 0 }
+
+/**
+ * @brief Logs a message unless its call site has exhausted its rate limit.
+ *
+ * Dropped messages are counted and reported as "N similar messages suppressed: <fmt>" right
+ * after the next message from the same site that is let through, or by logger_update() once
+ * they have been pending for a second. Safe to call from any thread; the bucket is updated
+ * under the logger lock.
+ */
+void logger_ratelimited(LogRateLimit* limit, enum LogLevel level, const char* fmt, ...);
+
+typedef void (*logger_ratelimited_fn_t)(LogRateLimit* limit, enum LogLevel level, const char* fmt, ...);
+
+/**
+ * @brief Registers a named log source (usually a plugin) and returns its id.
+ *
+ * Registering the same name twice returns the same id. Source 0 is the core itself.
+ */
+uint16_t logger_register_source(const char* name);
+
+/**
+ * @brief Sets the source that subsequent log calls from the calling thread are attributed to.
+ *
+ * The source is per thread; threads that never set one log as the core (source 0).
+ */
+void logger_set_source(uint16_t source);
+
+/**
+ * @brief Sets the minimum level logged for a source.
+ *
+ * @param source  Source name (plugin name), or NULL to set the default for every source.
+ * @param level   Messages below this level are dropped.
+ */
+void logger_set_level(const char* source, LogLevel level);
+
+typedef void (*logger_set_level_fn_t)(const char* source, LogLevel level);
+
+/**
+ * @brief Returns the minimum level logged for a source id.
+ */
+LogLevel logger_get_level(uint16_t source);
+
+/**
+ * @brief Returns the lowest level enabled for any source, kept current by logger_set_level().
+ *
+ * Messages below it are dropped for every source and thread, so it can be checked without
+ * knowing the calling thread's source; logger() still applies that source's own level.
+ */
+const _Atomic(LogLevel)* logger_level_floor(void);
+
+// ---------------- Binary log format ----------------
+
+#define LOG_BINARY_MAGIC   0x474F4C50u /* "PLOG" */
+#define LOG_BINARY_VERSION 2
+#define LOG_MAX_SOURCES    256
+
+/**
+ * @brief Kinds of records stored in a binary log file.
+ */
+typedef enum LogRecordKind
+{
+    LR_FORMAT = 1,  /**< Defines format string `id`; payload is the format text. */
+    LR_SOURCE,      /**< Defines source `id`; payload is the source name. */
+    LR_MESSAGE,     /**< A log call; payload is the raw argument bytes for format `id`. */
+} LogRecordKind;
+
+/**
+ * @brief Written once at the start of every binary log file.
+ */
+typedef struct LogBinaryFileHeader
+{
+    uint32_t magic;               /**< LOG_BINARY_MAGIC. */
+    uint16_t version;             /**< LOG_BINARY_VERSION. */
+    uint16_t record_header_size;  /**< sizeof(LogRecordHeader) of the writer. */
+} LogBinaryFileHeader;
+
+/**
+ * @brief Fixed-size header preceding every record payload.
+ */
+typedef struct LogRecordHeader
+{
+    uint8_t kind;           /**< LogRecordKind. */
+    uint8_t level;          /**< LogLevel of LR_MESSAGE records. */
+    uint16_t source;        /**< Source id the message is attributed to. */
+    uint32_t id;            /**< Format id (LR_FORMAT, LR_MESSAGE) or source id (LR_SOURCE). */
+    uint32_t size;          /**< Payload size in bytes. */
+    uint32_t reserved;
+    uint64_t timestamp_ns;  /**< Wall clock time in nanoseconds since the epoch. */
+} LogRecordHeader;
+
+/**
+ * @brief Argument classes understood by the binary encoder.
+ *
+ * Every argument is stored as 8 bytes, except strings which are stored as a
+ * 32-bit length followed by the characters, and wide strings which are stored
+ * as a 32-bit length followed by one 32-bit code unit per wchar_t.
+ */
+typedef enum LogArgType
+{
+    LA_NONE,      /**< `%%` or an unsupported conversion; consumes nothing. */
+    LA_INT,
+    LA_LONG,
+    LA_LLONG,
+    LA_SIZE,
+    LA_INTMAX,
+    LA_PTRDIFF,
+    LA_DOUBLE,
+    LA_LDOUBLE,   /**< Stored as a double. */
+    LA_STRING,
+    LA_POINTER,
+    LA_WCHAR,     /**< `%lc`, a wint_t. */
+    LA_WSTRING,   /**< `%ls`, a wchar_t string. */
+} LogArgType;
+
+/**
+ * @brief One conversion specification found in a format string.
+ */
+typedef struct LogFormatSpec
+{
+    const char* start;  /**< Points at the '%'. */
+    size_t len;         /**< Length of the whole specification. */
+    LogArgType type;    /**< Class of the converted argument. */
+    int stars;          /**< Number of `*` width/precision arguments preceding it. */
+} LogFormatSpec;
+
+/**
+ * @brief Finds the next conversion specification in a printf format string.
+ *
+ * @param fmt   Position to scan from.
+ * @param spec  Receives the specification.
+ * @return Pointer just past the specification, or NULL when none remain.
+ */
+const char* log_format_next(const char* fmt, LogFormatSpec* spec);
+
+#endif /*_CORE_LOGGER_H*/
@@ -101,6 +101,9 @@
  /**
   * @brief Initializes a MemoryMap with the given bucket count and function pointers.
   *
+  * If the bucket array cannot be allocated the map starts empty and the first insert
+  * retries the allocation.
+  *
   * @param mm Pointer to the MemoryMap to initialize.
   * @param buckets Number of hash buckets.
   * @param _malloc Memory allocation function.
@@ -19,6 +19,7 @@
      void* handle;     /**< Platform-specific handle to the loaded shared library. */
      char* name;       /**< Name of the plugin (typically filename or metadata name). */
      int version;      /**< Optional version tag (currently unused). */
+     uint16_t log_source; /**< Logger source id that log calls made by this plugin are attributed to. */
  } Plugin;
  
  /**
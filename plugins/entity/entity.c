@@ -315,7 +315,7 @@ int update(CoreContext *ctx)
             }
             else
             {
-                ctx->log(LL_ERROR, "Entity (%llu) [type:%s] has invalid custom state index %llu!", e->meta.id, e->type.name, index);
+                CC_LOG_RATELIMITED(ctx, LL_ERROR, 1.0f, 5.0f, "Entity (%llu) [type:%s] has invalid custom state index %llu!", e->meta.id, e->type.name, index);
             }
         }
     }
@@ -1,12 +1,15 @@
 #include "graphics.h"
 #include "../signals/signals.h"
 
-static signal_emit_fn_t signal_emit_fn;
+static signal_emit_id_fn_t signal_emit_id_fn;
+static SignalHandle draw_signal = SIGNAL_INVALID_HANDLE;
 
 int init(CoreContext *ctx)
 {
     (void)ctx;
-    signal_emit_fn = CC_GET(ctx,CC_SIGNAL_EMIT);
+    signal_register_fn_t signal_register_fn = CC_GET(ctx,CC_SIGNAL_REGISTER);
+    signal_emit_id_fn = CC_GET(ctx,CC_SIGNAL_EMIT_ID);
+    draw_signal = (*signal_register_fn)(CC_GRAPHICS_DRAW_SIGNAL);
     SetTargetFPS(60);
     InitWindow(800, 600, "Test");
     return 0;
@@ -22,7 +25,7 @@ int update(CoreContext *ctx)
 
     BeginDrawing();
     ClearBackground(WHITE);
-    (*signal_emit_fn)(ctx,CC_GRAPHICS_DRAW_SIGNAL,NULL,NULL);
+    (*signal_emit_id_fn)(ctx,draw_signal,NULL,NULL);
     EndDrawing();
     return 0;
 }
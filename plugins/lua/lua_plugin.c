@@ -14,6 +14,8 @@ static void (*signal_connect_fn)(const char*, SignalCallback, void*) = NULL;
 
 static int update_ref = LUA_NOREF;
 
+static MemoryMap log_limits; // "source:line" -> LogRateLimit
+
 // ====================================================
 // Core exposed functions
 // ====================================================
@@ -32,6 +34,39 @@ static int lua_log(lua_State *L)
     return 0;
 }
 
+/**
+ * @brief Log a message from Lua, rate limited per calling line.
+ *
+ * Lua Usage:
+ *     core.log_limited(message [, per_second = 1 [, burst = 5]])
+ */
+static int lua_log_limited(lua_State *L)
+{
+    const char *msg = luaL_checkstring(L, 1);
+    float per_second = (float)luaL_optnumber(L, 2, 1.0);
+    float burst = (float)luaL_optnumber(L, 3, 5.0);
+    CoreContext *ctx = lua_touserdata(L, lua_upvalueindex(1));
+
+    if (!CC_LOG_ENABLED(ctx, LL_INFO))
+        return 0;
+
+    // Key the limit on the calling script line
+    char site[128] = "?";
+    lua_Debug ar;
+    if (lua_getstack(L, 1, &ar) && lua_getinfo(L, "Sl", &ar))
+        snprintf(site, sizeof(site), "%s:%d", ar.short_src, ar.currentline);
+
+    LogRateLimit *limit = mm_get(&log_limits, STR(site));
+    if (!limit)
+    {
+        limit = mm_alloc(&log_limits, STR(site), sizeof(LogRateLimit));
+        *limit = (LogRateLimit)LOG_RATE_LIMIT_INIT(per_second, burst);
+    }
+
+    ctx->log_limited(limit, LL_INFO, "[lua] %s", msg);
+    return 0;
+}
+
 /**
  * @brief Emit a signal from Lua.
  *
@@ -190,6 +225,12 @@ int init(CoreContext *ctx)
     lua_pushcclosure(L, lua_log, 1);
     lua_setfield(L, -2, "log");
 
+    // Bind core.log_limited
+    mm_init(&log_limits, 32, malloc, free, mm_hash_default);
+    lua_pushlightuserdata(L, ctx);
+    lua_pushcclosure(L, lua_log_limited, 1);
+    lua_setfield(L, -2, "log_limited");
+
     // Bind core.signal_emit
     lua_pushlightuserdata(L, ctx);
     lua_pushcclosure(L, lua_signal_emit, 1);
@@ -265,6 +306,7 @@ int shutdown(CoreContext *ctx)
     }
 
     lua_close(L);
+    mm_free(&log_limits);
     return 0;
 }
 
@@ -10,6 +10,7 @@ static PyObject *python_signal_callback_map = NULL; // { signal_name: [callback_
 static PyObject *py_module = NULL;
 static PyObject *py_update = NULL;
 static int update_ref_exists = 0;
+static MemoryMap log_limits; // "file:line" -> LogRateLimit
 
 static void (*signal_emit_fn)(CoreContext *, const char *, void *, void *) = NULL;
 static void (*signal_connect_fn)(const char *, void (*)(CoreContext *, void *, void *, void *), void *) = NULL;
@@ -79,6 +80,59 @@ static PyObject* py_log(PyObject* self, PyObject* args)
     Py_RETURN_NONE;
 }
 
+/**
+ * @brief Log a message, rate limited per calling line.
+ *
+ * Python Usage:
+ *     core.log_limited(message: str, per_second: float = 1.0, burst: float = 5.0)
+ *
+ * Messages beyond the limit are dropped and later reported as
+ * "N similar messages suppressed".
+ *
+ * @param self  Unused.
+ * @param args  Tuple containing the message and optional rate and burst.
+ *
+ * @return None.
+ */
+static PyObject* py_log_limited(PyObject* self, PyObject* args)
+{
+    (void)self;
+    const char *msg;
+    float per_second = 1.0f;
+    float burst = 5.0f;
+    if (!PyArg_ParseTuple(args, "s|ff", &msg, &per_second, &burst))
+        return NULL;
+
+    if (!python_ctx || !CC_LOG_ENABLED(python_ctx, LL_INFO))
+        Py_RETURN_NONE;
+
+    // Key the limit on the calling script line
+    char site[256] = "?";
+    PyFrameObject *frame = PyEval_GetFrame();
+    if (frame)
+    {
+        PyCodeObject *code = PyFrame_GetCode(frame);
+        PyObject *filename = PyObject_GetAttrString((PyObject *)code, "co_filename");
+        const char *file = filename ? PyUnicode_AsUTF8(filename) : NULL;
+        snprintf(site, sizeof(site), "%s:%d", file ? file : "?", PyFrame_GetLineNumber(frame));
+        if (!file)
+            PyErr_Clear();
+        Py_XDECREF(filename);
+        Py_DECREF(code);
+    }
+
+    LogRateLimit *limit = mm_get(&log_limits, STR(site));
+    if (!limit)
+    {
+        limit = mm_alloc(&log_limits, STR(site), sizeof(LogRateLimit));
+        *limit = (LogRateLimit)LOG_RATE_LIMIT_INIT(per_second, burst);
+    }
+
+    python_ctx->log_limited(limit, LL_INFO, "[python] %s", msg);
+
+    Py_RETURN_NONE;
+}
+
 /**
  * @brief Emit a signal from Python.
  *
@@ -234,6 +288,11 @@ static PyMethodDef engine_methods[] = {
      "Logs a message to the engine console.\n"
      "Equivalent to C core logging.\n"},
 
+    {"log_limited", (PyCFunction)py_log_limited, METH_VARARGS,
+     "log_limited(message, per_second=1.0, burst=5.0)\n"
+     "Logs a message, allowing at most per_second messages per second from the calling line.\n"
+     "Dropped messages are reported as 'N similar messages suppressed'.\n"},
+
     {"signal_emit", (PyCFunction)py_signal_emit, METH_VARARGS,
      "signal_emit(name: str, sender: object, args: object)\n"
      "Emit a signal.\n"
@@ -274,6 +333,7 @@ static struct PyModuleDef engine_module = {
 int init(CoreContext *ctx)
 {
     python_ctx = ctx;
+    mm_init(&log_limits, 32, malloc, free, mm_hash_default);
 
     Py_Initialize();
 
@@ -413,6 +473,8 @@ int shutdown(CoreContext *ctx)
     if (Py_IsInitialized())
         Py_Finalize();
 
+    mm_free(&log_limits);
+
     return 0;
 }
 
@@ -0,0 +1,227 @@
+#include "replay.h"
+#include "../signals/signals.h"
+#include "../include/plugin.h"
+#include "../include/core_context.h"
+#include "../include/dt.h"
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+
+static signal_register_fn_t signal_register_fn;
+static signal_emit_id_fn_t signal_emit_id_fn;
+static signal_emit_batch_id_fn_t signal_emit_batch_id_fn;
+static signal_emit_deferred_id_fn_t signal_emit_deferred_id_fn;
+static signal_emit_deferred_copy_fn_t signal_emit_deferred_copy_fn;
+static signal_flush_fn_t signal_flush_fn;
+
+static struct {
+    unsigned char* data;              // whole trace file
+    size_t size;
+    size_t cursor;                    // offset of the next record
+    SignalHandle* handles;            // trace signal id -> live handle
+    size_t handle_count;
+    unsigned char* payload;           // aligned copy of the current record's payload
+    size_t payload_capacity;
+    ReplayMode mode;
+    uint32_t frame;                   // recorded frame being replayed
+    int active;
+} replay;
+
+// HELPER METHODS
+
+static void replay_reset(void) {
+    free(replay.data);
+    free(replay.handles);
+    free(replay.payload);
+    memset(&replay, 0, sizeof(replay));
+}
+
+static int replay_map_signal(uint32_t id, const char* name, size_t len) {
+    if (id >= replay.handle_count) {
+        size_t new_count = replay.handle_count ? replay.handle_count * 2 : 64;
+        while (new_count <= id)
+            new_count *= 2;
+        SignalHandle* handles = realloc(replay.handles, new_count * sizeof(SignalHandle));
+        if (!handles)
+            return 0;
+        memset(handles + replay.handle_count, 0, (new_count - replay.handle_count) * sizeof(SignalHandle));
+        replay.handles = handles;
+        replay.handle_count = new_count;
+    }
+
+    char* copy = malloc(len + 1);
+    if (!copy)
+        return 0;
+    memcpy(copy, name, len);
+    copy[len] = '\0';
+    replay.handles[id] = (*signal_register_fn)(copy);
+    free(copy);
+    return 1;
+}
+
+// Copies the next record header into `r`; returns 0 at the end of the trace or on a truncated record.
+// Records are packed back to back, so the header is copied out rather than read in place.
+static int replay_peek(SignalTraceRecord* r) {
+    if (replay.size - replay.cursor < sizeof(SignalTraceRecord))
+        return 0;
+    memcpy(r, replay.data + replay.cursor, sizeof(SignalTraceRecord));
+    if (replay.size - replay.cursor - sizeof(SignalTraceRecord) < r->size)
+        return 0;
+    return 1;
+}
+
+// Copies the payload of the record at the cursor into malloc-aligned storage listeners can cast
+static void* replay_payload(const SignalTraceRecord* r) {
+    if (!r->size)
+        return NULL;
+    if (r->size > replay.payload_capacity) {
+        unsigned char* payload = realloc(replay.payload, r->size);
+        if (!payload)
+            return NULL;
+        replay.payload = payload;
+        replay.payload_capacity = r->size;
+    }
+    memcpy(replay.payload, replay.data + replay.cursor + sizeof(SignalTraceRecord), r->size);
+    return replay.payload;
+}
+
+static void replay_record(CoreContext* ctx, const SignalTraceRecord* r) {
+    void* payload = replay_payload(r);
+    if (r->size && !payload)
+        return;
+    if (r->kind == ST_NAME) {
+        replay_map_signal(r->signal, (const char*)payload, r->size);
+        return;
+    }
+
+    SignalHandle signal = r->signal < replay.handle_count ? replay.handles[r->signal] : SIGNAL_INVALID_HANDLE;
+    void* sender = (void*)(uintptr_t)r->sender;
+    if (signal == SIGNAL_INVALID_HANDLE)
+        return;
+
+    if (r->kind == ST_DEFERRED) {
+        if (r->flags & ST_PAYLOAD)
+            (*signal_emit_deferred_copy_fn)(signal, sender, payload, r->size);
+        else
+            (*signal_emit_deferred_id_fn)(signal, sender, NULL);
+    } else if (r->kind == ST_EMIT) {
+        if (r->count > 1 || (r->flags & ST_PAYLOAD))
+            (*signal_emit_batch_id_fn)(ctx, signal, sender, payload, r->count, payload ? r->stride : 0);
+        else
+            (*signal_emit_id_fn)(ctx, signal, sender, NULL);
+    }
+}
+
+// Replays every record of the current frame; returns 0 once the trace is exhausted
+static int replay_frame(CoreContext* ctx) {
+    SignalTraceRecord r;
+    int more;
+    while ((more = replay_peek(&r)) && r.frame <= replay.frame) {
+        replay_record(ctx, &r);
+        replay.cursor += sizeof(SignalTraceRecord) + r.size;
+    }
+    replay.frame++;
+    return more;
+}
+
+// PUBLIC METHODS
+
+int replay_start(const char* path, ReplayMode mode) {
+    replay_reset();
+
+    FILE* in = fopen(path, "rb");
+    if (!in)
+        return 1;
+    fseek(in, 0, SEEK_END);
+    long size = ftell(in);
+    fseek(in, 0, SEEK_SET);
+
+    SignalTraceFileHeader header;
+    if (size < (long)sizeof(header) || fread(&header, sizeof(header), 1, in) != 1 ||
+        header.magic != SIGNAL_TRACE_MAGIC || header.version != SIGNAL_TRACE_VERSION ||
+        header.record_header_size != sizeof(SignalTraceRecord)) {
+        fclose(in);
+        return 1;
+    }
+
+    replay.size = (size_t)size - sizeof(header);
+    replay.data = malloc(replay.size ? replay.size : 1);
+    if (!replay.data || fread(replay.data, 1, replay.size, in) != replay.size) {
+        fclose(in);
+        replay_reset();
+        return 1;
+    }
+    fclose(in);
+
+    // Start at the first recorded frame rather than idling through the frames before recording began
+    SignalTraceRecord first;
+    replay.frame = replay_peek(&first) ? first.frame : 0;
+    replay.mode = mode;
+    replay.active = 1;
+    return 0;
+}
+
+// PLUGIN API
+
+int init(CoreContext* ctx) {
+    signal_register_fn = CC_GET(ctx, CC_SIGNAL_REGISTER);
+    signal_emit_id_fn = CC_GET(ctx, CC_SIGNAL_EMIT_ID);
+    signal_emit_batch_id_fn = CC_GET(ctx, CC_SIGNAL_EMIT_BATCH_ID);
+    signal_emit_deferred_id_fn = CC_GET(ctx, CC_SIGNAL_DEFERRED_ID);
+    signal_emit_deferred_copy_fn = CC_GET(ctx, CC_SIGNAL_DEFERRED_COPY);
+    signal_flush_fn = CC_GET(ctx, CC_SIGNAL_FLUSH);
+
+    CC_BIND(ctx, CC_REPLAY_START, replay_start, sizeof(replay_start), false);
+
+    const char* path = getenv("SIGNAL_REPLAY");
+    const char* mode = getenv("SIGNAL_REPLAY_MODE");
+    if (path && *path && replay_start(path, mode && strcmp(mode, "fast") == 0 ? REPLAY_FAST : REPLAY_FRAMES) != 0)
+        CC_LOG_ERROR(ctx, "[replay] could not load trace %s", path);
+    return 0;
+}
+
+int update(CoreContext* ctx) {
+    if (!replay.active)
+        return 0;
+
+    if (replay.mode == REPLAY_FRAMES) {
+        replay.active = replay_frame(ctx);
+        if (!replay.active)
+            CC_LOG_INFO(ctx, "[replay] trace finished");
+        return 0;
+    }
+
+    uint64_t start = dt_now_ns();
+    uint32_t first_frame = replay.frame;
+    size_t records = 0;
+    for (int more = 1; more; ) {
+        size_t before = replay.cursor;
+        more = replay_frame(ctx);
+        records += replay.cursor != before;
+        (*signal_flush_fn)(ctx);
+    }
+    double ms = (dt_now_ns() - start) / 1e6;
+    CC_LOG_INFO(ctx, "[replay] %u frames (%zu with traffic) replayed in %.3f ms",
+                replay.frame - first_frame, records, ms);
+    replay.active = 0;
+    return 0;
+}
+
+int shutdown(CoreContext* ctx) {
+    (void)ctx;
+    replay_reset();
+    return 0;
+}
+
+static const char* deps[] = { "Signals", NULL };
+static const char* optional[] = { NULL };
+static PluginMetadata meta = { "Replay", deps, optional };
+
+PluginAPI Load() {
+    return (PluginAPI){
+        .init = init,
+        .update = update,
+        .shutdown = shutdown,
+        .meta = &meta
+    };
+}
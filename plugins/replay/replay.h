@@ -0,0 +1,45 @@
+/**
+ * @file replay.h
+ * @brief Replays signal traces recorded by the Signals plugin.
+ *
+ * A trace (see `signal_record_start()`) is loaded into memory and its emits are re-issued
+ * through the Signals plugin, either paced at the recorded frame boundaries or as fast as
+ * possible, flushing the deferred queue between frames. Senders are passed as their recorded
+ * pointer values and must be treated as opaque ids by listeners; args that were not recorded
+ * are passed as NULL.
+ *
+ * Setting `SIGNAL_REPLAY=<trace>` starts a replay at init; `SIGNAL_REPLAY_MODE=fast` selects
+ * the unpaced mode.
+ */
+
+ #ifndef _REPLAY_H
+ #define _REPLAY_H
+
+ #include "../../include/plugin_api.h"
+
+ /**
+  * Starts replaying a trace file.
+  *
+  * Signature:
+  *   int (*)(const char* path, ReplayMode mode)
+  */
+ #define CC_REPLAY_START "replay::start"
+
+ /**
+  * @brief How recorded frames are paced.
+  */
+ typedef enum {
+     REPLAY_FRAMES = 0,              /**< One recorded frame per update of the Replay plugin. */
+     REPLAY_FAST,                    /**< Everything in the next update, flushing between frames, then log the timing. */
+ } ReplayMode;
+
+ /**
+  * @brief Loads a trace and starts replaying it, replacing any replay in progress.
+  *
+  * @return 0 on success, non-zero if the file is missing or not a valid trace.
+  */
+ int replay_start(const char* path, ReplayMode mode);
+
+ typedef int (*replay_start_fn_t)(const char* path, ReplayMode mode);
+
+ #endif /* _REPLAY_H */
@@ -1,65 +1,850 @@
 #include "scheduler.h"
+#include "../threads/threads.h"
+#include "../signals/signals.h"
+#include "../../include/dt.h"
 #include <stdlib.h>
+#include <string.h>
+#include <stdatomic.h>
 
 #define DEFAULT_CAPACITY 16
+#define WHEEL_MASK (SCHEDULER_WHEEL_SLOTS - 1)
+#define SCHEDULER_ASYNC_WORKERS 2
 
-static Scheduler* scheduler = NULL; 
+static Scheduler* scheduler = NULL;
+static signal_connect_fn_t signal_connect_fn = NULL;     // NULL without the Signals plugin
+static signal_disconnect_fn_t signal_disconnect_fn = NULL;
 
-typedef void (*SchedulerRegisterFn)(const char*, float, ScheduledFn, void*);
+enum { ASYNC_QUEUED, ASYNC_RUNNING, ASYNC_ABANDONED };
 
+/* One async call. Owned by the main thread, except between being claimed and completing. */
+typedef struct SchedulerAsyncJob {
+    ScheduledFn fn;
+    void* user_data;
+    CoreContext* ctx;
+    uint32_t index;                       // task slot and generation, to find the task on completion
+    uint32_t generation;
+    _Atomic int state;                    // ASYNC_QUEUED until a worker claims it
+    struct SchedulerAsyncJob* next;       // completion list or fallback queue
+    struct SchedulerAsyncJob* flight_prev; // in-flight list, main thread only
+    struct SchedulerAsyncJob* flight_next;
+} SchedulerAsyncJob;
+
+static struct {
+    thread_spawn_fn_t spawn;              // Threads plugin, NULL to use the fallback workers
+    mtx_t lock;                           // guards `completed` and the fallback queue
+    cnd_t wake;                           // fallback workers sleep on it
+    SchedulerAsyncJob* completed;
+    SchedulerAsyncJob* queue_head;
+    SchedulerAsyncJob* queue_tail;
+    SchedulerAsyncJob* in_flight;
+    size_t in_flight_count;
+    thrd_t workers[SCHEDULER_ASYNC_WORKERS];
+    int worker_count;
+    bool quit;
+} async;
+
+static uint64_t seconds_to_ns(double seconds)
+{
+    return seconds > 0.0 ? (uint64_t)(seconds * 1e9 + 0.5) : 0;
+}
+
+static uint64_t scheduler_clock(void)
+{
+    return dt_now_ns() - scheduler->epoch;
+}
+
+// ---------------- Task slab ----------------
+
+static uint32_t task_alloc(void)
+{
+    uint32_t index = scheduler->free_head;
+    if (index) {
+        scheduler->free_head = scheduler->tasks[index].next;
+        return index;
+    }
+    if (scheduler->count >= scheduler->capacity) {
+        size_t new_capacity = scheduler->capacity * 2;
+        ScheduledTask* tasks = realloc(scheduler->tasks, new_capacity * sizeof(ScheduledTask));
+        if (!tasks)
+            return 0;
+        scheduler->tasks = tasks;
+        scheduler->capacity = new_capacity;
+    }
+    index = (uint32_t)scheduler->count++;
+    scheduler->tasks[index].generation = 1;
+    return index;
+}
+
+static void task_release(uint32_t index)
+{
+    ScheduledTask* task = &scheduler->tasks[index];
+    task->fn = NULL;
+    task->co_fn = NULL;
+    task->list = SCHEDULER_LIST_FREE;
+    task->generation++;
+    if (task->generation == 0)
+        task->generation = 1;
+    task->next = scheduler->free_head;
+    scheduler->free_head = index;
+    scheduler->active--;
+}
+
+static ScheduledTask* task_get(SchedulerHandle handle, uint32_t* index)
+{
+    uint32_t slot = (uint32_t)handle;
+    if (!scheduler || slot == 0 || slot >= scheduler->count)
+        return NULL;
+    ScheduledTask* task = &scheduler->tasks[slot];
+    if (task->generation != (uint32_t)(handle >> 32) || task->list == SCHEDULER_LIST_FREE)
+        return NULL;
+    *index = slot;
+    return task;
+}
+
+// ---------------- Ready heap ----------------
+
+/* Higher priority first, then earlier deadline. */
+static bool ready_before(uint32_t a, uint32_t b)
+{
+    const ScheduledTask* ta = &scheduler->tasks[a];
+    const ScheduledTask* tb = &scheduler->tasks[b];
+    if (ta->priority != tb->priority)
+        return ta->priority > tb->priority;
+    return ta->deadline < tb->deadline;
+}
+
+static int ready_compare(const void* a, const void* b)
+{
+    uint32_t ia = *(const uint32_t*)a, ib = *(const uint32_t*)b;
+    return ready_before(ia, ib) ? -1 : ready_before(ib, ia) ? 1 : 0;
+}
+
+static void ready_set(size_t pos, uint32_t index)
+{
+    scheduler->ready[pos] = index;
+    scheduler->tasks[index].heap_index = (uint32_t)pos;
+}
+
+static void ready_sift_up(size_t pos)
+{
+    uint32_t index = scheduler->ready[pos];
+    while (pos > 0) {
+        size_t parent = (pos - 1) / 2;
+        if (!ready_before(index, scheduler->ready[parent]))
+            break;
+        ready_set(pos, scheduler->ready[parent]);
+        pos = parent;
+    }
+    ready_set(pos, index);
+}
+
+static void ready_sift_down(size_t pos)
+{
+    uint32_t index = scheduler->ready[pos];
+    for (;;) {
+        size_t child = pos * 2 + 1;
+        if (child >= scheduler->ready_count)
+            break;
+        if (child + 1 < scheduler->ready_count && ready_before(scheduler->ready[child + 1], scheduler->ready[child]))
+            child++;
+        if (!ready_before(scheduler->ready[child], index))
+            break;
+        ready_set(pos, scheduler->ready[child]);
+        pos = child;
+    }
+    ready_set(pos, index);
+}
+
+static void wheel_insert(uint32_t index);
+
+/* Queues a due task. If the heap cannot grow, the task stays on the wheel and is collected again next update. */
+static void ready_push(uint32_t index)
+{
+    if (scheduler->ready_count == scheduler->ready_capacity) {
+        size_t new_capacity = scheduler->ready_capacity ? scheduler->ready_capacity * 2 : 64;
+        uint32_t* ready = realloc(scheduler->ready, new_capacity * sizeof(uint32_t));
+        if (ready)
+            scheduler->ready = ready;
+        uint32_t* overdue = ready ? realloc(scheduler->overdue, new_capacity * sizeof(uint32_t)) : NULL;
+        if (overdue)
+            scheduler->overdue = overdue;
+        if (!ready || !overdue) {
+            wheel_insert(index);
+            return;
+        }
+        scheduler->ready_capacity = new_capacity;
+    }
+    scheduler->tasks[index].list = SCHEDULER_LIST_READY;
+    scheduler->ready[scheduler->ready_count] = index;
+    ready_sift_up(scheduler->ready_count++);
+}
+
+static void ready_remove(uint32_t index)
+{
+    size_t pos = scheduler->tasks[index].heap_index;
+    uint32_t last = scheduler->ready[--scheduler->ready_count];
+    scheduler->tasks[index].list = SCHEDULER_LIST_NONE;
+    if (pos < scheduler->ready_count) {
+        ready_set(pos, last);
+        ready_sift_up(pos);
+        ready_sift_down(scheduler->tasks[last].heap_index);
+    }
+}
+
+// ---------------- Timing wheel ----------------
+
+static void list_push(uint32_t list, uint32_t index)
+{
+    ScheduledTask* task = &scheduler->tasks[index];
+    uint32_t head = scheduler->lists[list];
+    task->list = list;
+    task->prev = 0;
+    task->next = head;
+    if (head)
+        scheduler->tasks[head].prev = index;
+    scheduler->lists[list] = index;
+    if (list < SCHEDULER_WHEEL_SLOTS)
+        scheduler->occupied[list >> 6] |= 1ull << (list & 63);
+}
+
+static void list_unlink(uint32_t index)
+{
+    ScheduledTask* task = &scheduler->tasks[index];
+    uint32_t list = task->list;
+    if (list >= SCHEDULER_LIST_COUNT)
+        return;
+    if (task->prev)
+        scheduler->tasks[task->prev].next = task->next;
+    else
+        scheduler->lists[list] = task->next;
+    if (task->next)
+        scheduler->tasks[task->next].prev = task->prev;
+    if (list < SCHEDULER_WHEEL_SLOTS && !scheduler->lists[list])
+        scheduler->occupied[list >> 6] &= ~(1ull << (list & 63));
+    task->list = SCHEDULER_LIST_NONE;
+}
+
+/* Detaches a whole list, the caller walks it through `next` and re-files every task. */
+static uint32_t list_take(uint32_t list)
+{
+    uint32_t head = scheduler->lists[list];
+    scheduler->lists[list] = 0;
+    if (list < SCHEDULER_WHEEL_SLOTS)
+        scheduler->occupied[list >> 6] &= ~(1ull << (list & 63));
+    return head;
+}
+
+/* Takes a task out of whichever wheel list, heap or signal wait holds it. */
+static void task_detach(uint32_t index)
+{
+    ScheduledTask* task = &scheduler->tasks[index];
+    if (task->list == SCHEDULER_LIST_READY) {
+        ready_remove(index);
+    } else if (task->list == SCHEDULER_LIST_SIGNAL) {
+        signal_disconnect_fn(task->co.signal_id);
+        task->list = SCHEDULER_LIST_NONE;
+    } else if (task->list != SCHEDULER_LIST_FREE) {
+        list_unlink(index);
+    }
+}
+
+/*
+ * Files a task by its deadline tick: level L holds ticks whose 256^L block is at most 255
+ * blocks ahead, so every slot is cascaded one level down exactly when its block starts.
+ */
+static void wheel_insert(uint32_t index)
+{
+    ScheduledTask* task = &scheduler->tasks[index];
+    uint64_t tick = task->deadline / SCHEDULER_TICK_NS;
+    if (tick < scheduler->tick)
+        tick = scheduler->tick;
+
+    for (uint32_t level = 0; level < SCHEDULER_WHEEL_LEVELS; ++level) {
+        uint32_t shift = level * SCHEDULER_WHEEL_BITS;
+        if ((tick >> shift) - (scheduler->tick >> shift) < SCHEDULER_WHEEL_SLOTS) {
+            list_push(level * SCHEDULER_WHEEL_SLOTS + (uint32_t)((tick >> shift) & WHEEL_MASK), index);
+            return;
+        }
+    }
+    list_push(SCHEDULER_LIST_OVERFLOW, index);
+}
+
+static void wheel_refile(uint32_t head)
+{
+    while (head) {
+        uint32_t next = scheduler->tasks[head].next;
+        wheel_insert(head);
+        head = next;
+    }
+}
+
+/* Refiles the higher level slots whose block starts at `tick`, highest first so tasks can fall several levels. */
+static void wheel_cascade(uint64_t tick)
+{
+    for (uint32_t level = SCHEDULER_WHEEL_LEVELS - 1; level > 0; --level) {
+        uint32_t shift = level * SCHEDULER_WHEEL_BITS;
+        if (tick & ((1ull << shift) - 1))
+            continue;
+        if (level == SCHEDULER_WHEEL_LEVELS - 1 && ((tick >> shift) & WHEEL_MASK) == 0)
+            wheel_refile(list_take(SCHEDULER_LIST_OVERFLOW));
+        wheel_refile(list_take(level * SCHEDULER_WHEEL_SLOTS + (uint32_t)((tick >> shift) & WHEEL_MASK)));
+    }
+}
+
+static void wheel_enter(uint64_t tick)
+{
+    scheduler->tick = tick;
+    if ((tick & WHEEL_MASK) == 0)
+        wheel_cascade(tick);
+}
+
+/* First non-empty level 0 slot at or after `from`, or SCHEDULER_WHEEL_SLOTS. */
+static uint32_t wheel_next_occupied(uint32_t from)
+{
+    for (uint32_t word = from >> 6; word < SCHEDULER_WHEEL_SLOTS / 64; ++word) {
+        uint64_t bits = scheduler->occupied[word];
+        if (word == from >> 6)
+            bits &= ~0ull << (from & 63);
+        if (bits)
+            return (word << 6) + (uint32_t)__builtin_ctzll(bits);
+    }
+    return SCHEDULER_WHEEL_SLOTS;
+}
+
+/*
+ * Moves the due tasks of a level 0 slot to the ready heap. `next_tick` is the tick the wheel
+ * moves to, so tasks filed by the callbacks land after the slot being collected.
+ */
+static void wheel_collect(uint32_t slot, uint64_t next_tick)
+{
+    uint32_t head = list_take(slot);
+    if (next_tick != scheduler->tick)
+        wheel_enter(next_tick);
+
+    while (head) {
+        uint32_t next = scheduler->tasks[head].next;
+        if (scheduler->tasks[head].deadline > scheduler->now)
+            wheel_insert(head); // due later within the current tick
+        else
+            ready_push(head);
+        head = next;
+    }
+}
+
+/*
+ * Collects every tick before `target` and the tasks of `target` that are already due, jumping
+ * over empty level 0 slots. The wheel stays on `target` until the clock has passed it.
+ */
+static void wheel_advance(uint64_t target)
+{
+    while (scheduler->tick <= target) {
+        uint64_t tick = scheduler->tick;
+        uint64_t block = tick & ~(uint64_t)WHEEL_MASK;
+        uint32_t slot = wheel_next_occupied((uint32_t)(tick & WHEEL_MASK));
+        if (slot < SCHEDULER_WHEEL_SLOTS && block + slot <= target) {
+            uint64_t fired = block + slot;
+            wheel_collect(slot, fired < target ? fired + 1 : fired);
+            if (fired == target)
+                return;
+        } else if (block + SCHEDULER_WHEEL_SLOTS <= target) {
+            wheel_enter(block + SCHEDULER_WHEEL_SLOTS);
+        } else {
+            scheduler->tick = target;
+            return;
+        }
+    }
+}
+
+// ---------------- Async execution ----------------
+
+static int async_entry(void* arg)
+{
+    SchedulerAsyncJob* job = arg;
+    int expected = ASYNC_QUEUED;
+    if (!atomic_compare_exchange_strong(&job->state, &expected, ASYNC_RUNNING)) {
+        free(job); // abandoned at shutdown before it started
+        return 0;
+    }
+    job->fn(job->ctx, job->user_data);
+
+    mtx_lock(&async.lock);
+    job->next = async.completed;
+    async.completed = job;
+    mtx_unlock(&async.lock);
+    return 0;
+}
+
+/* Fallback pool used when the Threads plugin is not loaded. */
+static int async_worker(void* arg)
+{
+    (void)arg;
+    mtx_lock(&async.lock);
+    for (;;) {
+        while (!async.queue_head && !async.quit)
+            cnd_wait(&async.wake, &async.lock);
+        SchedulerAsyncJob* job = async.queue_head;
+        if (!job)
+            break;
+        async.queue_head = job->next;
+        if (!async.queue_head)
+            async.queue_tail = NULL;
+        mtx_unlock(&async.lock);
+        async_entry(job);
+        mtx_lock(&async.lock);
+    }
+    mtx_unlock(&async.lock);
+    return 0;
+}
+
+static void async_dispatch(CoreContext* ctx, uint32_t index)
+{
+    ScheduledTask* task = &scheduler->tasks[index];
+    SchedulerAsyncJob* job = malloc(sizeof(SchedulerAsyncJob));
+    if (!job) {
+        task->fn(ctx, task->user_data);
+        task = &scheduler->tasks[index];
+        if (task->on_complete)
+            task->on_complete(ctx, task->user_data);
+        return;
+    }
+    job->fn = task->fn;
+    job->user_data = task->user_data;
+    job->ctx = ctx;
+    job->index = index;
+    job->generation = task->generation;
+    atomic_init(&job->state, ASYNC_QUEUED);
+    job->next = NULL;
+    job->flight_prev = NULL;
+    job->flight_next = async.in_flight;
+    if (async.in_flight)
+        async.in_flight->flight_prev = job;
+    async.in_flight = job;
+    async.in_flight_count++;
+    task->running = true;
+
+    if (async.spawn) {
+        async.spawn(async_entry, job);
+        return;
+    }
+
+    // Workers start on the first async call, so that schedulers without async tasks stay single threaded
+    while (!async.worker_count && !async.quit) {
+        for (int i = 0; i < SCHEDULER_ASYNC_WORKERS; ++i)
+            if (thrd_create(&async.workers[async.worker_count], async_worker, NULL) == thrd_success)
+                async.worker_count++;
+        if (!async.worker_count)
+            async.quit = true; // no threads available, run async tasks inline from now on
+    }
+    if (!async.worker_count) {
+        async_entry(job);
+        return;
+    }
+
+    mtx_lock(&async.lock);
+    if (async.queue_tail)
+        async.queue_tail->next = job;
+    else
+        async.queue_head = job;
+    async.queue_tail = job;
+    cnd_signal(&async.wake);
+    mtx_unlock(&async.lock);
+}
+
+/* Runs the main thread side of finished async calls. */
+static void async_drain(CoreContext* ctx)
+{
+    mtx_lock(&async.lock);
+    SchedulerAsyncJob* job = async.completed;
+    async.completed = NULL;
+    mtx_unlock(&async.lock);
+
+    while (job) {
+        SchedulerAsyncJob* next = job->next;
+        if (job->flight_prev)
+            job->flight_prev->flight_next = job->flight_next;
+        else
+            async.in_flight = job->flight_next;
+        if (job->flight_next)
+            job->flight_next->flight_prev = job->flight_prev;
+        async.in_flight_count--;
+
+        ScheduledTask* task = &scheduler->tasks[job->index];
+        if (task->generation == job->generation && task->list != SCHEDULER_LIST_FREE) {
+            task->running = false;
+            if (task->on_complete)
+                task->on_complete(ctx, task->user_data);
+            // A finished one-shot is released here rather than when it was dispatched
+            task = &scheduler->tasks[job->index];
+            if (task->generation == job->generation && !task->interval && !task->running && task->list == SCHEDULER_LIST_NONE)
+                task_release(job->index);
+        }
+        free(job);
+        job = next;
+    }
+}
+
+/* Abandons calls that have not started and waits for the running ones. */
+static void async_shutdown(CoreContext* ctx)
+{
+    for (SchedulerAsyncJob* job = async.in_flight; job;) {
+        SchedulerAsyncJob* next = job->flight_next;
+        int expected = ASYNC_QUEUED;
+        if (atomic_compare_exchange_strong(&job->state, &expected, ASYNC_ABANDONED)) {
+            // Whoever picks it up frees it
+            if (job->flight_prev)
+                job->flight_prev->flight_next = job->flight_next;
+            else
+                async.in_flight = job->flight_next;
+            if (job->flight_next)
+                job->flight_next->flight_prev = job->flight_prev;
+            async.in_flight_count--;
+        }
+        job = next;
+    }
+
+    while (async.in_flight_count) {
+        async_drain(ctx);
+        if (async.in_flight_count)
+            thrd_yield();
+    }
+
+    mtx_lock(&async.lock);
+    async.quit = true;
+    cnd_broadcast(&async.wake);
+    mtx_unlock(&async.lock);
+    for (int i = 0; i < async.worker_count; ++i)
+        thrd_join(async.workers[i], NULL);
+    async.worker_count = 0;
+    mtx_destroy(&async.lock);
+    cnd_destroy(&async.wake);
+}
+
+// ---------------- Coroutines ----------------
+
+static void co_signal_wake(CoreContext* ctx, void* sender, void* args, void* user_data)
+{
+    (void)ctx;
+    (void)args;
+    uint32_t index = (uint32_t)(uintptr_t)user_data;
+    ScheduledTask* task = &scheduler->tasks[index];
+    if (task->list != SCHEDULER_LIST_SIGNAL)
+        return;
+    signal_disconnect_fn(task->co.signal_id);
+    task->co.sender = sender;
+    task->list = SCHEDULER_LIST_NONE;
+    // Due when woken, not at the deadline of the step that started waiting: a stale deadline would
+    // sort ahead of on-time tasks and count the whole wait as lateness
+    task->deadline = scheduler_clock();
+    ready_push(index);
+}
+
+/* Moves the coroutines whose frame wait ends this update to the ready heap. */
+static void frame_collect(void)
+{
+    uint32_t list = SCHEDULER_LIST_FRAMES + (uint32_t)(scheduler->frame % SCHEDULER_FRAME_SLOTS);
+    uint32_t head = list_take(list);
+    while (head) {
+        uint32_t next = scheduler->tasks[head].next;
+        if (scheduler->tasks[head].co.wake_frame <= scheduler->frame) {
+            scheduler->tasks[head].deadline = scheduler->now; // due now, like a signal wake
+            ready_push(head);
+        }
+        else
+            list_push(list, head); // a later lap of the ring
+        head = next;
+    }
+}
+
+/* Runs one step of a coroutine and files it on the wait it asked for. */
+static void co_resume(CoreContext* ctx, uint32_t index)
+{
+    ScheduledTask* task = &scheduler->tasks[index];
+    SchedulerCo co = task->co;
+    SchedulerCoWait woken_by = co.wait;
+    uint32_t generation = task->generation;
+    co.wait = SCHEDULER_CO_WAIT_NONE;
+    SchedulerCoStatus status = task->co_fn(ctx, &co, task->user_data);
+
+    task = &scheduler->tasks[index];
+    if (task->generation != generation)
+        return; // cancelled itself
+    task->co = co;
+    if (task->list != SCHEDULER_LIST_NONE)
+        return; // rescheduled itself
+    if (status == SCHEDULER_CO_DONE) {
+        task_release(index);
+        return;
+    }
+
+    if (co.wait == SCHEDULER_CO_WAIT_SIGNAL && !signal_connect_fn) {
+        CC_LOG_RATELIMITED(ctx, LL_WARN, 1.0f, 1.0f, "Coroutine '%s' awaits signal '%s' but the Signals plugin is not loaded", task->name ? task->name : "?", co.signal);
+        co.wait = SCHEDULER_CO_WAIT_FRAMES;
+        co.frames = 1;
+    }
+
+    switch (co.wait) {
+    case SCHEDULER_CO_WAIT_SECONDS: {
+        // Chained waits count from the deadline that woke the step, so they do not gather frame lateness
+        uint64_t base = woken_by == SCHEDULER_CO_WAIT_SECONDS ? task->deadline : scheduler->now;
+        task->deadline = base + seconds_to_ns(co.seconds);
+        wheel_insert(index);
+        break;
+    }
+    case SCHEDULER_CO_WAIT_SIGNAL:
+        task->list = SCHEDULER_LIST_SIGNAL;
+        task->co.signal_id = signal_connect_fn(co.signal, co_signal_wake, (void*)(uintptr_t)index);
+        break;
+    default:
+        task->co.wait = SCHEDULER_CO_WAIT_FRAMES;
+        task->co.wake_frame = scheduler->frame + (co.frames ? co.frames : 1);
+        list_push(SCHEDULER_LIST_FRAMES + (uint32_t)(task->co.wake_frame % SCHEDULER_FRAME_SLOTS), index);
+        break;
+    }
+}
+
+// ---------------- Execution ----------------
+
+/* Runs a task taken off the ready heap and files its next deadline. */
+static void task_run(CoreContext* ctx, uint32_t index)
+{
+    ScheduledTask* task = &scheduler->tasks[index];
+    if (task->co_fn) {
+        co_resume(ctx, index);
+        return;
+    }
+    uint64_t now = scheduler->now;
+    if (task->catch_up == SCHEDULER_CATCH_UP_SKIP && task->interval && now - task->deadline >= task->interval) {
+        task->deadline += (now - task->deadline) / task->interval * task->interval + task->interval;
+        wheel_insert(index);
+        return;
+    }
+
+    uint32_t generation = task->generation;
+    if (task->mode == SCHEDULER_EXEC_ASYNC) {
+        // Never overlaps itself: a call that comes due while the last one runs is dropped
+        if (!task->running)
+            async_dispatch(ctx, index);
+    } else {
+        task->fn(ctx, task->user_data);
+    }
+
+    // The callback may have grown the slab, cancelled or rescheduled the task
+    task = &scheduler->tasks[index];
+    if (task->generation != generation || task->list != SCHEDULER_LIST_NONE)
+        return;
+    if (!task->interval) {
+        if (!task->running)
+            task_release(index);
+        return;
+    }
+
+    // Stay on the deadline grid: next = previous + interval, whatever the frame time was
+    task->deadline += task->interval;
+    if (task->deadline <= now) {
+        if (task->catch_up == SCHEDULER_CATCH_UP_ALL) {
+            ready_push(index);
+            return;
+        }
+        task->deadline += (now - task->deadline) / task->interval * task->interval + task->interval;
+    }
+    wheel_insert(index);
+}
+
+/*
+ * Runs due tasks in priority order until the heap is empty or the frame budget is spent.
+ * Tasks left over stay in the heap for the next frame, except those that have reached their
+ * maximum lateness, which run anyway.
+ */
+static void scheduler_run_ready(CoreContext* ctx)
+{
+    uint64_t start = dt_now_ns();
+    for (bool first = true; scheduler->ready_count; first = false) {
+        if (scheduler->budget && !first && dt_now_ns() - start >= scheduler->budget)
+            break;
+        uint32_t index = scheduler->ready[0];
+        ready_remove(index);
+        task_run(ctx, index);
+    }
+    if (!scheduler->ready_count) {
+        scheduler->carried = 0;
+        return;
+    }
+
+    size_t overdue = 0;
+    for (size_t i = 0; i < scheduler->ready_count; ++i) {
+        ScheduledTask* task = &scheduler->tasks[scheduler->ready[i]];
+        if (task->max_lateness && scheduler->now - task->deadline >= task->max_lateness)
+            scheduler->overdue[overdue++] = scheduler->ready[i];
+    }
+    qsort(scheduler->overdue, overdue, sizeof(uint32_t), ready_compare);
+    for (size_t i = 0; i < overdue; ++i) {
+        uint32_t index = scheduler->overdue[i];
+        if (scheduler->tasks[index].list != SCHEDULER_LIST_READY)
+            continue; // cancelled or rescheduled by an earlier callback
+        ready_remove(index);
+        task_run(ctx, index);
+    }
+    scheduler->carried = scheduler->ready_count;
+}
+
+static SchedulerHandle scheduler_add(const char* name, uint64_t delay, uint64_t interval, const SchedulerTaskDesc* desc, ScheduledFn fn, void* user_data)
+{
+    uint32_t index = task_alloc();
+    if (!index)
+        return SCHEDULER_INVALID_HANDLE;
+
+    ScheduledTask* task = &scheduler->tasks[index];
+    task->name = name;
+    task->interval = interval;
+    task->deadline = scheduler_clock() + delay;
+    task->catch_up = desc ? desc->catch_up : SCHEDULER_CATCH_UP_ONCE;
+    task->priority = desc ? desc->priority : 0;
+    task->mode = desc ? desc->mode : SCHEDULER_EXEC_MAIN;
+    task->on_complete = desc ? desc->on_complete : NULL;
+    task->co_fn = desc ? desc->coroutine : NULL;
+    memset(&task->co, 0, sizeof(task->co));
+    task->running = false;
+    task->max_lateness = desc ? seconds_to_ns(desc->max_lateness) : 0;
+    task->fn = fn;
+    task->user_data = user_data;
+    scheduler->active++;
+    wheel_insert(index);
+    return ((SchedulerHandle)task->generation << 32) | index;
+}
+
+// ---------------- Plugin ----------------
 
 int init(CoreContext* ctx)
 {
     scheduler = ctx->memory.alloc(&ctx->memory.map,LIT("SCHEDULER"),sizeof(Scheduler));
     CC_BIND(ctx,CC_SCHEDULER_REGISTER,scheduler_register,sizeof(scheduler_register),false);
+    CC_BIND(ctx,CC_SCHEDULER_REGISTER_EX,scheduler_register_ex,sizeof(scheduler_register_ex),false);
+    CC_BIND(ctx,CC_SCHEDULER_ONCE,scheduler_once,sizeof(scheduler_once),false);
+    CC_BIND(ctx,CC_SCHEDULER_CANCEL,scheduler_cancel,sizeof(scheduler_cancel),false);
+    CC_BIND(ctx,CC_SCHEDULER_RESCHEDULE,scheduler_reschedule,sizeof(scheduler_reschedule),false);
+    CC_BIND(ctx,CC_SCHEDULER_SET_BUDGET,scheduler_set_budget,sizeof(scheduler_set_budget),false);
+    CC_BIND(ctx,CC_SCHEDULER_START_COROUTINE,scheduler_start_coroutine,sizeof(scheduler_start_coroutine),false);
+    signal_connect_fn = CC_GET(ctx, CC_SIGNAL_CONNECT);
+    signal_disconnect_fn = CC_GET(ctx, CC_SIGNAL_DISCONNECT);
+    memset(&async, 0, sizeof(async));
+    async.spawn = CC_GET(ctx, CC_THREAD_SPAWN); // NULL without the Threads plugin
+    mtx_init(&async.lock, mtx_plain);
+    cnd_init(&async.wake);
     scheduler->tasks = malloc(DEFAULT_CAPACITY * sizeof(ScheduledTask));
     scheduler->capacity = DEFAULT_CAPACITY;
-    scheduler->count = 0;
+    scheduler->count = 1; // slot 0 keeps handle 0 invalid
+    scheduler->active = 0;
+    scheduler->free_head = 0;
+    memset(scheduler->lists, 0, sizeof(scheduler->lists));
+    memset(scheduler->occupied, 0, sizeof(scheduler->occupied));
+    scheduler->epoch = dt_now_ns();
+    scheduler->now = 0;
+    scheduler->tick = 0;
+    scheduler->frame = 0;
+    scheduler->ready = scheduler->overdue = NULL;
+    scheduler->ready_count = scheduler->ready_capacity = scheduler->carried = 0;
+    scheduler->stagger_seq = 0;
+    const char* budget = getenv("SCHEDULER_BUDGET_MS");
+    scheduler->budget = budget ? seconds_to_ns(atof(budget) / 1000.0) : 0;
     return 0;
 };
 
 int shutdown(CoreContext* ctx)
 {
-    (void)ctx; /* suppress unused variable */
+    async_shutdown(ctx);
+    for (size_t i = 1; i < scheduler->count; ++i)
+        if (scheduler->tasks[i].list == SCHEDULER_LIST_SIGNAL)
+            signal_disconnect_fn(scheduler->tasks[i].co.signal_id);
     free(scheduler->tasks);
+    free(scheduler->ready);
+    free(scheduler->overdue);
+    scheduler->tasks = NULL;
+    scheduler->ready = scheduler->overdue = NULL;
+    scheduler->ready_count = scheduler->ready_capacity = 0;
+    scheduler->count = scheduler->capacity = scheduler->active = 0;
     return 0;
 }
 
 int update(CoreContext* ctx) {
-    for (size_t i = 0; i < scheduler->count; i++) {
-        ScheduledTask* task = &scheduler->tasks[i];
-        task->elapsed += ctx->delta_time;
-        if (task->elapsed >= task->interval) {
-            task->fn(ctx, task->user_data);
-            task->elapsed = 0.0f;
-        }
-    }
+    async_drain(ctx);
+    scheduler->now = scheduler_clock();
+    scheduler->frame++;
+    frame_collect();
+    wheel_advance(scheduler->now / SCHEDULER_TICK_NS);
+    scheduler_run_ready(ctx);
     return 0;
 }
 
-void scheduler_register(const char* name, float interval, ScheduledFn fn, void* user_data)
+SchedulerHandle scheduler_register(const char* name, float interval, ScheduledFn fn, void* user_data)
 {
-    if (!scheduler || !fn || interval <= 0.0f) return;
+    if (interval <= 0.0f) return SCHEDULER_INVALID_HANDLE;
+    // Round to whole microseconds so that e.g. 0.1f is exactly 100 ms instead of 100.0000015 ms
+    double seconds = (double)(uint64_t)((double)interval * 1e6 + 0.5) / 1e6;
+    SchedulerTaskDesc desc = {.name = name, .fn = fn, .user_data = user_data, .interval = seconds, .delay = seconds};
+    return scheduler_register_ex(&desc);
+}
 
-    if (scheduler->count >= scheduler->capacity) {
-        size_t new_capacity = scheduler->capacity * 2;
-        scheduler->tasks = realloc(scheduler->tasks, new_capacity * sizeof(ScheduledTask));
-        scheduler->capacity = new_capacity;
+SchedulerHandle scheduler_register_ex(const SchedulerTaskDesc* desc)
+{
+    if (!scheduler || !desc || !(desc->fn || desc->coroutine) || desc->interval < 0.0) return SCHEDULER_INVALID_HANDLE;
+    uint64_t interval = desc->coroutine ? 0 : seconds_to_ns(desc->interval);
+    if (desc->interval > 0.0 && !interval)
+        interval = 1;
+    uint64_t delay = desc->delay < 0.0 ? interval : seconds_to_ns(desc->delay);
+    if (desc->stagger && interval) {
+        // Golden ratio sequence, so any number of tasks registered together land evenly over the interval
+        double phase = (double)((++scheduler->stagger_seq * 0x9E3779B97F4A7C15ull) >> 11) / 9007199254740992.0;
+        delay = interval - (uint64_t)(phase * (double)interval);
     }
+    return scheduler_add(desc->name, delay, interval, desc, desc->fn, desc->user_data);
+}
 
-    ScheduledTask* task = &scheduler->tasks[scheduler->count++];
-    task->name = name; // optional if you're using it
-    task->interval = interval;
-    task->elapsed = 0.0f;
-    task->fn = fn;
-    task->user_data = user_data;
+SchedulerHandle scheduler_start_coroutine(const char* name, SchedulerCoFn fn, void* user_data)
+{
+    SchedulerTaskDesc desc = {.name = name, .user_data = user_data, .coroutine = fn};
+    return scheduler_register_ex(&desc);
+}
+
+SchedulerHandle scheduler_once(const char* name, float delay, ScheduledFn fn, void* user_data)
+{
+    if (!scheduler || !fn) return SCHEDULER_INVALID_HANDLE;
+    return scheduler_add(name, seconds_to_ns(delay), 0, NULL, fn, user_data);
+}
+
+bool scheduler_cancel(SchedulerHandle handle)
+{
+    uint32_t index;
+    if (!task_get(handle, &index))
+        return false;
+    task_detach(index);
+    task_release(index);
+    return true;
+}
+
+bool scheduler_reschedule(SchedulerHandle handle, float delay, float interval)
+{
+    uint32_t index;
+    ScheduledTask* task = task_get(handle, &index);
+    if (!task)
+        return false;
+    task_detach(index);
+    task->interval = seconds_to_ns(interval);
+    task->deadline = scheduler_clock() + seconds_to_ns(delay);
+    wheel_insert(index);
+    return true;
+}
+
+void scheduler_set_budget(double seconds)
+{
+    if (scheduler)
+        scheduler->budget = seconds_to_ns(seconds);
 }
 
 static const char* deps[] = {NULL};
-static const char* optional[] = { NULL };
+static const char* optional[] = { "Threads", "Signals", NULL };
 static PluginMetadata meta = {"Scheduler", deps, optional};
 
 PluginAPI Load()
 {
     return (PluginAPI){init,update,shutdown,&meta};
-}
\ No newline at end of file
+}
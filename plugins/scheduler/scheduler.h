@@ -4,15 +4,58 @@
  *
  * This scheduler allows plugins to register recurring tasks that run at fixed intervals.
  * Each task is associated with a callback function and optional user data.
+ *
+ * Tasks are kept in a hierarchical timing wheel (SCHEDULER_WHEEL_LEVELS levels of
+ * SCHEDULER_WHEEL_SLOTS slots, SCHEDULER_TICK_NS per tick), so a frame only touches the
+ * tasks that fire in it instead of every registered task.
+ *
+ * Deadlines are absolute nanoseconds on the monotonic clock (dt_now_ns) and a periodic
+ * task's next deadline is its previous one plus the interval, so late frames never make a
+ * task drift.
+ *
+ * Due tasks go through a ready heap ordered by priority. With a frame budget set
+ * (scheduler_set_budget, or `SCHEDULER_BUDGET_MS=N`) the tasks left when the budget runs out
+ * carry over to the next frame, unless they have reached their maximum lateness.
+ *
+ * SCHEDULER_EXEC_ASYNC tasks run on the Threads plugin's workers (or on the Scheduler's own
+ * tinycthread workers when Threads is not loaded) and report back on the main thread.
+ *
+ * Coroutine tasks (SchedulerCoFn, see SCHEDULER_CO_BEGIN) are stackless: each await returns
+ * to the Scheduler, which files the task in the timing wheel, a frame ring or a Signals
+ * connection, and resumes it when that wakes it up.
  */
 
  #ifndef _SCHEDULER
  #define _SCHEDULER
- 
+
  #include "../../include/plugin_api.h"
+ #include <stdint.h>
+ #include <stdbool.h>
 
  #define CC_SCHEDULER_REGISTER "scheduler::register"
- 
+ #define CC_SCHEDULER_REGISTER_EX "scheduler::register_ex"
+ #define CC_SCHEDULER_ONCE "scheduler::once"
+ #define CC_SCHEDULER_CANCEL "scheduler::cancel"
+ #define CC_SCHEDULER_RESCHEDULE "scheduler::reschedule"
+ #define CC_SCHEDULER_SET_BUDGET "scheduler::set_budget"
+ #define CC_SCHEDULER_START_COROUTINE "scheduler::start_coroutine"
+
+ #define SCHEDULER_TICK_NS 1000000ull   /**< Resolution of the wheel (1 ms). */
+ #define SCHEDULER_WHEEL_BITS 8
+ #define SCHEDULER_WHEEL_SLOTS (1u << SCHEDULER_WHEEL_BITS)
+ #define SCHEDULER_WHEEL_LEVELS 4      /**< 4 levels of 256 ticks cover ~49 days, later tasks wait in an overflow list. */
+ #define SCHEDULER_FRAME_SLOTS 256     /**< Ring of per-frame lists for coroutines awaiting frames. */
+
+ /**
+  * @brief Identifies a registered task.
+  *
+  * Packs the task slot (low 32 bits) with the slot generation (high 32 bits), so a handle
+  * to a task that already finished or was cancelled is ignored.
+  */
+ typedef uint64_t SchedulerHandle;
+
+ #define SCHEDULER_INVALID_HANDLE 0
+
  /**
   * @brief Function pointer type for scheduled tasks.
   *
@@ -20,38 +63,245 @@
   * @param user_data  Optional user data provided at registration.
   */
  typedef void (*ScheduledFn)(CoreContext* ctx, void* user_data);
- 
+
+ /**
+  * @brief What a periodic task does when the clock has passed more than one of its deadlines.
+  */
+ typedef enum {
+     SCHEDULER_CATCH_UP_ONCE,  /**< Run once, then continue from the next deadline still ahead. */
+     SCHEDULER_CATCH_UP_ALL,   /**< Run once for every missed deadline, in the same frame. */
+     SCHEDULER_CATCH_UP_SKIP,  /**< Drop the call if it is a whole interval or more late, run it otherwise. */
+ } SchedulerCatchUp;
+
+ /**
+  * @brief Returned by a coroutine step.
+  */
+ typedef enum {
+     SCHEDULER_CO_DONE,   /**< Finished, the task is released. */
+     SCHEDULER_CO_WAIT,   /**< Suspended on the wait described in the SchedulerCo. */
+ } SchedulerCoStatus;
+
+ /**
+  * @brief What a suspended coroutine waits for.
+  */
+ typedef enum {
+     SCHEDULER_CO_WAIT_NONE,
+     SCHEDULER_CO_WAIT_SECONDS,
+     SCHEDULER_CO_WAIT_FRAMES,
+     SCHEDULER_CO_WAIT_SIGNAL,
+ } SchedulerCoWait;
+
+ /**
+  * @brief Resume state of a coroutine task.
+  *
+  * The Scheduler passes a copy to every step, so it stays valid while the step registers
+  * more tasks. Locals of the step function do not survive an await; keep them in user_data.
+  */
+ typedef struct {
+     int line;                 /**< Resume point (`__LINE__` of the last await), 0 before the first step. */
+     SchedulerCoWait wait;     /**< Wait requested by the last await. */
+     double seconds;           /**< SCHEDULER_CO_WAIT_SECONDS duration. */
+     uint32_t frames;          /**< SCHEDULER_CO_WAIT_FRAMES count. */
+     const char* signal;       /**< SCHEDULER_CO_WAIT_SIGNAL name. */
+     void* sender;             /**< Sender of the signal that ended the last signal wait. */
+     uint64_t signal_id;       /**< Connection of a pending signal wait (Scheduler owned). */
+     uint64_t wake_frame;      /**< Frame that ends a pending frame wait (Scheduler owned). */
+ } SchedulerCo;
+
+ /**
+  * @brief One step of a coroutine task, written with the SCHEDULER_CO_* macros.
+  */
+ typedef SchedulerCoStatus (*SchedulerCoFn)(CoreContext* ctx, SchedulerCo* co, void* user_data);
+
+ /**
+  * @def SCHEDULER_CO_BEGIN
+  * @brief Opens the body of a coroutine step, e.g.
+  *
+  *     SCHEDULER_CO_BEGIN(co);
+  *     SCHEDULER_CO_AWAIT_SECONDS(co, 0.5);
+  *     do_x(state);
+  *     SCHEDULER_CO_AWAIT_SIGNAL(co, "door::opened");
+  *     do_z(state);
+  *     SCHEDULER_CO_END(co);
+  *
+  * Awaits resume through a `switch` on the saved line, so there can be at most one per
+  * source line and none inside another `switch` of the same body.
+  */
+ #define SCHEDULER_CO_BEGIN(co) switch ((co)->line) { case 0:
+
+ #define SCHEDULER_CO_AWAIT_(co, request) \
+     do { request; (co)->line = __LINE__; return SCHEDULER_CO_WAIT; case __LINE__:; } while (0)
+
+ /** @brief Suspends for `s` seconds, measured from the deadline that resumed it when there was one. */
+ #define SCHEDULER_CO_AWAIT_SECONDS(co, s) \
+     SCHEDULER_CO_AWAIT_(co, ((co)->wait = SCHEDULER_CO_WAIT_SECONDS, (co)->seconds = (s)))
+
+ /** @brief Suspends for `n` Scheduler updates (at least one). */
+ #define SCHEDULER_CO_AWAIT_FRAMES(co, n) \
+     SCHEDULER_CO_AWAIT_(co, ((co)->wait = SCHEDULER_CO_WAIT_FRAMES, (co)->frames = (n)))
+
+ /** @brief Suspends until the named signal is emitted; `co->sender` then holds its sender. */
+ #define SCHEDULER_CO_AWAIT_SIGNAL(co, name) \
+     SCHEDULER_CO_AWAIT_(co, ((co)->wait = SCHEDULER_CO_WAIT_SIGNAL, (co)->signal = (name)))
+
+ /** @brief Suspends until the next update. */
+ #define SCHEDULER_CO_YIELD(co) SCHEDULER_CO_AWAIT_FRAMES(co, 1)
+
+ #define SCHEDULER_CO_END(co) } (co)->line = -1; return SCHEDULER_CO_DONE
+
+ /**
+  * @brief Where a task's function runs.
+  */
+ typedef enum {
+     SCHEDULER_EXEC_MAIN,   /**< Inside the Scheduler's update, on the main thread. */
+     SCHEDULER_EXEC_ASYNC,  /**< On a worker thread; `on_complete` then runs on the main thread. */
+ } SchedulerExecMode;
+
+ /**
+  * @brief Describes a task for scheduler_register_ex().
+  */
+ typedef struct {
+     const char* name;           /**< Optional name (used for debugging). */
+     ScheduledFn fn;             /**< Function to call. */
+     void* user_data;            /**< Optional data passed to the callback. */
+     double interval;            /**< Seconds between calls, 0 for a one-shot timer. */
+     double delay;               /**< Seconds until the first call (`interval` when negative). */
+     SchedulerCatchUp catch_up;  /**< Behaviour after missed deadlines. */
+     int priority;               /**< Due tasks run highest priority first. */
+     bool stagger;               /**< Spread the first call over (0, interval] instead of using `delay`. */
+     double max_lateness;        /**< Seconds a due task may be carried over by the frame budget, 0 for no limit. */
+     SchedulerExecMode mode;     /**< SCHEDULER_EXEC_ASYNC runs `fn` on a worker, it must only touch thread-safe state. */
+     ScheduledFn on_complete;    /**< Optional, called on the main thread after an async call finished. */
+     SchedulerCoFn coroutine;    /**< Runs a coroutine instead of `fn`; `delay` is the first step, `interval` is ignored. */
+ } SchedulerTaskDesc;
+
  /**
   * @brief Represents a single scheduled task.
   */
  typedef struct {
      const char* name;        /**< The name of the task (optional, for debugging/logging). */
-     float interval;          /**< Time interval in seconds between calls. */
-     float elapsed;           /**< Internal tracker for time since last call. */
-     ScheduledFn fn;          /**< The function to call at the specified interval. */
+     uint64_t interval;       /**< Nanoseconds between calls, 0 for a one-shot timer. */
+     uint64_t deadline;       /**< Scheduler time (ns) of the next call. */
+     uint64_t max_lateness;   /**< Nanoseconds the task may be carried over past its deadline, 0 for no limit. */
+     SchedulerCatchUp catch_up; /**< Behaviour after missed deadlines. */
+     int priority;            /**< Due tasks run highest priority first. */
+     SchedulerExecMode mode;  /**< Where `fn` runs. */
+     bool running;            /**< An async call is in flight; due calls are dropped until it completes. */
+     ScheduledFn on_complete; /**< Called on the main thread after each async call. */
+     ScheduledFn fn;          /**< The function to call at the specified interval, NULL for coroutines. */
+     SchedulerCoFn co_fn;     /**< Coroutine step, NULL for plain tasks. */
+     SchedulerCo co;          /**< Coroutine resume state. */
      void* user_data;         /**< Optional data passed to the callback. */
+     uint32_t generation;     /**< Bumped every time the slot is released. */
+     uint32_t next;           /**< Next task in the same wheel list, or next free slot. */
+     uint32_t prev;           /**< Previous task in the same wheel list. */
+     uint32_t list;           /**< Wheel or frame list holding the task, a SCHEDULER_LIST_* state otherwise. */
+     uint32_t heap_index;     /**< Position in the ready heap while the task is due. */
  } ScheduledTask;
- 
+
+ #define SCHEDULER_LIST_NONE UINT32_MAX          /**< Running, or an async call in flight. */
+ #define SCHEDULER_LIST_READY (UINT32_MAX - 1)    /**< Due, in the ready heap. */
+ #define SCHEDULER_LIST_SIGNAL (UINT32_MAX - 2)   /**< Coroutine waiting on a signal connection. */
+ #define SCHEDULER_LIST_FREE (UINT32_MAX - 3)     /**< Slot on the free list. */
+ #define SCHEDULER_LIST_OVERFLOW (SCHEDULER_WHEEL_LEVELS * SCHEDULER_WHEEL_SLOTS)
+ #define SCHEDULER_LIST_FRAMES (SCHEDULER_LIST_OVERFLOW + 1)
+ #define SCHEDULER_LIST_COUNT (SCHEDULER_LIST_FRAMES + SCHEDULER_FRAME_SLOTS)
+
  /**
-  * @brief A resizable list of scheduled tasks.
+  * @brief The task slab and the timing wheel indexing it.
   */
  typedef struct {
-     ScheduledTask* tasks;    /**< Array of scheduled tasks. */
-     size_t count;            /**< Number of active tasks. */
+     ScheduledTask* tasks;    /**< Task slab, slot 0 is unused so that handle 0 stays invalid. */
+     size_t count;            /**< Number of slots in use or on the free list. */
      size_t capacity;         /**< Allocated capacity of the task array. */
+     size_t active;           /**< Number of registered tasks. */
+     uint32_t free_head;      /**< First released slot, 0 when none. */
+     uint32_t lists[SCHEDULER_LIST_COUNT]; /**< Heads of the wheel slot lists (level * SLOTS + slot), the overflow list and the frame ring. */
+     uint64_t occupied[SCHEDULER_WHEEL_SLOTS / 64]; /**< Bitmap of non-empty level 0 slots, lets a frame skip empty ticks. */
+     uint64_t epoch;          /**< dt_now_ns() at init, scheduler time 0. */
+     uint64_t now;            /**< Scheduler time in nanoseconds, read at the start of the frame. */
+     uint64_t tick;           /**< First tick the wheel has not processed yet. */
+     uint64_t frame;          /**< Number of updates so far. */
+     uint32_t* ready;         /**< Binary heap of due tasks, highest priority then earliest deadline first. */
+     size_t ready_count;      /**< Number of due tasks. */
+     size_t ready_capacity;   /**< Allocated size of `ready` and `overdue`. */
+     uint32_t* overdue;       /**< Scratch list of tasks that reached their maximum lateness. */
+     uint64_t budget;         /**< Nanoseconds of task execution per frame, 0 for no limit. */
+     uint64_t stagger_seq;    /**< Number of staggered registrations so far. */
+     size_t carried;          /**< Due tasks carried over to the next frame by the budget. */
  } Scheduler;
- 
+
  /**
   * @brief Registers a new task to run periodically.
   *
+  * Equivalent to scheduler_register_ex() with SCHEDULER_CATCH_UP_ONCE.
+  *
   * @param name       Optional name for the task (used for debugging).
   * @param interval   Time interval in seconds between executions.
   * @param fn         Function pointer to be called on each interval.
   * @param user_data  Optional pointer to user-defined data.
+  * @return Handle for scheduler_cancel()/scheduler_reschedule(), or SCHEDULER_INVALID_HANDLE.
+  */
+ SchedulerHandle scheduler_register(const char* name, float interval, ScheduledFn fn, void* user_data);
+
+ typedef SchedulerHandle (*scheduler_register_fn_t)(const char* name, float interval, ScheduledFn fn, void* user_data);
+
+ /**
+  * @brief Registers a task from a description.
+  *
+  * @return Handle for scheduler_cancel()/scheduler_reschedule(), or SCHEDULER_INVALID_HANDLE.
+  */
+ SchedulerHandle scheduler_register_ex(const SchedulerTaskDesc* desc);
+
+ typedef SchedulerHandle (*scheduler_register_ex_fn_t)(const SchedulerTaskDesc* desc);
+
+ /**
+  * @brief Registers a task that runs once after `delay` seconds and is then released.
+  */
+ SchedulerHandle scheduler_once(const char* name, float delay, ScheduledFn fn, void* user_data);
+
+ typedef SchedulerHandle (*scheduler_once_fn_t)(const char* name, float delay, ScheduledFn fn, void* user_data);
+
+ /**
+  * @brief Starts a coroutine task; its first step runs on the next update.
   */
- void scheduler_register(const char* name, float interval, ScheduledFn fn, void* user_data);
+ SchedulerHandle scheduler_start_coroutine(const char* name, SchedulerCoFn fn, void* user_data);
+
+ typedef SchedulerHandle (*scheduler_start_coroutine_fn_t)(const char* name, SchedulerCoFn fn, void* user_data);
+
+ /**
+  * @brief Removes a task. Safe to call from any task callback, including the task's own.
+  *
+  * An async call already running finishes, but its `on_complete` is not called.
+  *
+  * @return true if the handle referred to a registered task.
+  */
+ bool scheduler_cancel(SchedulerHandle handle);
+
+ typedef bool (*scheduler_cancel_fn_t)(SchedulerHandle handle);
+
+ /**
+  * @brief Moves the next call of a task to `delay` seconds from now.
+  *
+  * @param handle    Task to move.
+  * @param delay     Seconds until the next call.
+  * @param interval  New interval in seconds, 0 turns the task into a one-shot timer.
+  * @return true if the handle referred to a registered task.
+  */
+ bool scheduler_reschedule(SchedulerHandle handle, float delay, float interval);
+
+ typedef bool (*scheduler_reschedule_fn_t)(SchedulerHandle handle, float delay, float interval);
+
+ /**
+  * @brief Limits the time spent running tasks in one frame.
+  *
+  * The highest priority due task always runs; once `seconds` have elapsed the remaining
+  * due tasks wait for the next frame.
+  *
+  * @param seconds  Budget per frame, 0 to run every due task.
+  */
+ void scheduler_set_budget(double seconds);
+
+ typedef void (*scheduler_set_budget_fn_t)(double seconds);
 
- typedef void (*scheduler_register_fn_t)(const char* name, float interval, ScheduledFn fn, void* user_data);
- 
  #endif /* _SCHEDULER */
- 
\ No newline at end of file
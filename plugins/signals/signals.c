@@ -1,146 +1,1777 @@
 #include "signals.h"
+#include "../threads/threads.h"
 #include "../include/plugin.h"
 #include "../include/core_context.h"
 #include "../include/memory_map.h"
+#include "../include/dt.h"
 #include <stdlib.h>
 #include <string.h>
 #include <stdio.h>
+#include <stdatomic.h>
 
 // HELPER METHODS
 
-static MemoryMap signal_map;
-static SignalQueueArray signal_queue;
-static SignalID signal_id_counter = 1;
+static MemoryMap signal_map;          // name -> SignalHandle
+static struct {
+    SignalEntry* data;                // indexed by SignalHandle, slot 0 unused
+    size_t count;
+    size_t capacity;
+} signal_table;
+static struct {
+    SignalSlot* data;                 // indexed by the low half of a SignalID, slot 0 unused
+    size_t count;
+    size_t capacity;
+    uint32_t free_head;               // 0 = none
+} slot_table;
+static struct {
+    SignalPattern* data;              // indexed by the low half of a pattern id, slot 0 unused
+    size_t count;
+    size_t capacity;
+    uint32_t free_head;               // 0 = none
+    uint32_t match_stamp;
+    SignalPatternNode root;
+} pattern_table;
+// Profiling; counters are always kept, times only while `stats_timing` is set
+static int stats_timing = 0;
+static float stats_interval = 0.0f;   // seconds between dumps, 0 = never
+static float stats_elapsed = 0.0f;
+static struct {
+    uint32_t last_depth;              // emissions delivered by the last flush
+    uint32_t max_depth;
+} flush_stats;
+// Trace recording
+static struct {
+    FILE* file;
+    uint8_t* named;                   // per handle: ST_NAME record written
+    size_t named_capacity;
+} trace;
+static uint32_t signal_frame = 0;     // bumped by every flush
+static uint32_t dispatch_depth = 0;   // > 0 while listeners run; their emits are not recorded
+// Double buffered: signals deferred while a flush is running land in the other queue
+static SignalQueueArray signal_queues[2];
+static int signal_queue_active = 0;
+static int flushing = 0;              // a flush is dispatching; nested flushes are ignored
+// Reused by every flush to regroup the queue by signal
+static struct {
+    SignalEvent* events;
+    size_t events_capacity;
+    struct { SignalHandle signal; size_t count; }* groups; // signals in order of first appearance
+    size_t groups_capacity;
+} flush_scratch;
+
+#define SIGNAL_BATCH_STACK 32         // signal_emit_batch spans up to this size avoid the heap
+
+// Parallel dispatch of thread-safe listeners through the (optional) Threads plugin
+#define SIGNAL_PARALLEL_HELPERS 4     // most jobs spawned per parallel emit, besides the emitting thread
+#define SIGNAL_PARALLEL_CHUNKS 4      // chunks per participant, to balance uneven listeners
+static thread_spawn_fn_t thread_spawn_fn = NULL;
+static thread_job_wait_fn_t thread_job_wait_fn = NULL;
+static int parallel_helpers = 0;      // min(pool workers, SIGNAL_PARALLEL_HELPERS)
+static size_t parallel_threshold = SIGNAL_PARALLEL_THRESHOLD;
+
+// Shared by the emitting thread and its helper jobs. The emitting thread waits on every helper
+// with thread::job_wait, which runs a helper itself if no worker has picked it up yet, so the
+// state outlives all of them and is freed by the emit.
+typedef struct {
+    _Atomic size_t next_chunk;
+    JobHandle helpers[SIGNAL_PARALLEL_HELPERS];
+    size_t chunks;
+    size_t chunk_size;
+    CoreContext* ctx;
+    const SignalEvent* events;
+    size_t count;
+    size_t conn_count;
+    SignalConnection conns[];         // snapshot of the thread-safe connections
+} SignalParallelEmit;
+
+#define SIGNAL_ARENA_ALIGN 16
+#define SIGNAL_ARENA_INITIAL 4096
+
+// Deferred signals from other threads go through per-thread single-producer queues made of
+// fixed chunks. Producers only publish with release stores and never take a lock; the main
+// thread drains every queue in registration order during signal_flush.
+//
+// A queue is retired when its thread exits: a tss destructor marks it dead and the next flush
+// drains it, unlinks it and frees it. Registering and unlinking take `thread_queue_registry_lock`;
+// the drain itself walks the list without it.
+//
+// Jobs can still run after shutdown (Threads shuts down later and finishes its queue), so
+// shutdown frees the queues of threads that have exited and orphans the rest: an orphan's
+// thread frees it on its next push (a thread that never defers again keeps its header, whose
+// destructor goes with the tss key). A producer marks its queue busy before
+// checking `thread_queues_open`; shutdown closes them and waits for busy queues, so a push
+// either lands before the chunks are freed or is dropped.
+#define SIGNAL_THREAD_CHUNK 256
+#define SIGNAL_INLINE_PAYLOAD 64
+
+typedef struct {
+    SignalHandle signal;              // SIGNAL_INVALID_HANDLE when `name` must be resolved
+    char* name;                       // owned copy, resolved and freed by the drain
+    void* sender;
+    void* args;
+    size_t payload_size;
+    unsigned char* payload_heap;      // payloads over SIGNAL_INLINE_PAYLOAD
+    _Alignas(SIGNAL_ARENA_ALIGN) unsigned char payload[SIGNAL_INLINE_PAYLOAD];
+} ThreadSignal;
+
+typedef struct ThreadSignalChunk {
+    _Atomic size_t count;             // entries published by the producer
+    size_t read;                      // entries consumed by the main thread
+    struct ThreadSignalChunk* _Atomic next;
+    ThreadSignal items[SIGNAL_THREAD_CHUNK];
+} ThreadSignalChunk;
+
+enum {
+    THREAD_QUEUE_LIVE,
+    THREAD_QUEUE_DEAD,                // its thread exited; freed by the drain once empty
+    THREAD_QUEUE_ORPHANED,            // dropped by shutdown while its thread lives; the thread frees it
+};
+
+typedef struct ThreadSignalQueue {
+    ThreadSignalChunk* head;          // consumer side
+    ThreadSignalChunk* tail;          // producer side
+    _Atomic int busy;                 // producer is between the open check and publishing
+    _Atomic int state;
+    struct ThreadSignalQueue* _Atomic next;
+} ThreadSignalQueue;
+
+static ThreadSignalQueue thread_queue_registry; // sentinel
+static atomic_flag thread_queue_registry_lock = ATOMIC_FLAG_INIT;
+static _Thread_local ThreadSignalQueue* thread_queue = NULL;
+static tss_t thread_queue_key;                  // runs thread_queue_retire when a producer exits
+static int thread_queue_key_valid = 0;
+static atomic_bool thread_queues_open = false;
+static _Thread_local int is_main_thread = 0;
 
 static void signal_queue_init(SignalQueueArray* q) {
+    memset(q, 0, sizeof(*q));
+    q->coalesce_stamp = 1;
     q->capacity = 16;
     q->count = 0;
     q->data = malloc(sizeof(QueuedSignal) * q->capacity);
+    q->arena_capacity = SIGNAL_ARENA_INITIAL;
+    q->arena_used = 0;
+    q->arena = malloc(q->arena_capacity);
 }
 
-static void signal_queue_push(SignalQueueArray* q, const char* name, void* sender, void* args) {
+static QueuedSignal* signal_queue_push(SignalQueueArray* q, SignalHandle signal, void* sender, void* args) {
     if (q->count >= q->capacity) {
-        q->capacity *= 2;
-        q->data = realloc(q->data, q->capacity * sizeof(QueuedSignal));
+        size_t new_capacity = q->capacity * 2;
+        QueuedSignal* data = realloc(q->data, new_capacity * sizeof(QueuedSignal));
+        if (!data)
+            return NULL;
+        q->data = data;
+        q->capacity = new_capacity;
+    }
+    QueuedSignal* s = &q->data[q->count++];
+    *s = (QueuedSignal){ signal, sender, args, 0, 0 };
+    return s;
+}
+
+// Returns the arena offset of `size` freshly reserved bytes, or SIZE_MAX if the arena cannot grow
+static size_t signal_arena_alloc(SignalQueueArray* q, size_t size) {
+    size_t offset = (q->arena_used + SIGNAL_ARENA_ALIGN - 1) & ~(size_t)(SIGNAL_ARENA_ALIGN - 1);
+    if (offset + size > q->arena_capacity) {
+        size_t new_capacity = q->arena_capacity * 2;
+        while (offset + size > new_capacity)
+            new_capacity *= 2;
+        unsigned char* arena = realloc(q->arena, new_capacity);
+        if (!arena)
+            return SIZE_MAX;
+        q->arena = arena;
+        q->arena_capacity = new_capacity;
     }
-    q->data[q->count++] = (QueuedSignal){ name, sender, args };
+    q->arena_used = offset + size;
+    return offset;
 }
 
 static void signal_queue_clear(SignalQueueArray* q) {
     q->count = 0;
+    q->arena_used = 0;
+    q->coalesce_count = 0;
+    if (++q->coalesce_stamp == 0) {
+        // Stamp wrapped: entries from 2^32 frames ago would look current again
+        memset(q->coalesce, 0, q->coalesce_capacity * sizeof(SignalCoalesceEntry));
+        q->coalesce_stamp = 1;
+    }
+}
+
+static size_t signal_sender_hash(SignalHandle signal, void* sender) {
+    uint64_t h = (uint64_t)(uintptr_t)sender ^ ((uint64_t)signal << 40);
+    h ^= h >> 33;
+    h *= 0xff51afd7ed558ccdull; // murmur3 finalizer
+    h ^= h >> 33;
+    return (size_t)h;
+}
+
+static int signal_coalesce_grow(SignalQueueArray* q) {
+    size_t new_capacity = q->coalesce_capacity ? q->coalesce_capacity * 2 : 64;
+    SignalCoalesceEntry* map = calloc(new_capacity, sizeof(SignalCoalesceEntry));
+    if (!map)
+        return 0;
+
+    size_t mask = new_capacity - 1;
+    for (size_t i = 0; i < q->coalesce_capacity; ++i) {
+        SignalCoalesceEntry* e = &q->coalesce[i];
+        if (e->stamp != q->coalesce_stamp)
+            continue;
+        size_t idx = signal_sender_hash(e->signal, e->sender) & mask;
+        while (map[idx].stamp == q->coalesce_stamp)
+            idx = (idx + 1) & mask;
+        map[idx] = *e;
+    }
+    free(q->coalesce);
+    q->coalesce = map;
+    q->coalesce_capacity = new_capacity;
+    return 1;
+}
+
+// Finds the (signal, sender) entry of this frame, or claims an empty one with index SIZE_MAX
+static SignalCoalesceEntry* signal_coalesce_find(SignalQueueArray* q, SignalHandle signal, void* sender) {
+    if ((q->coalesce_count + 1) * 2 > q->coalesce_capacity && !signal_coalesce_grow(q))
+        return NULL;
+
+    size_t mask = q->coalesce_capacity - 1;
+    size_t idx = signal_sender_hash(signal, sender) & mask;
+    while (q->coalesce[idx].stamp == q->coalesce_stamp) {
+        SignalCoalesceEntry* e = &q->coalesce[idx];
+        if (e->signal == signal && e->sender == sender)
+            return e;
+        idx = (idx + 1) & mask;
+    }
+
+    SignalCoalesceEntry* e = &q->coalesce[idx];
+    *e = (SignalCoalesceEntry){ signal, q->coalesce_stamp, sender, SIZE_MAX };
+    q->coalesce_count++;
+    return e;
 }
 
 static void signal_queue_free(SignalQueueArray* q) {
     free(q->data);
+    free(q->arena);
+    free(q->coalesce);
     q->data = NULL;
+    q->arena = NULL;
+    q->coalesce = NULL;
+    q->coalesce_count = 0;
+    q->coalesce_capacity = 0;
     q->count = 0;
     q->capacity = 0;
+    q->arena_used = 0;
+    q->arena_capacity = 0;
 }
 
-SignalConnectionArray* get_or_create_signal_array(const char* name) {
-    String key = STR((char*)name);
-    SignalConnectionArray* arr = mm_get(&signal_map, key);
-    if (!arr) {
-        arr = malloc(sizeof(SignalConnectionArray));
-        arr->count = 0;
-        arr->capacity = 4;
-        arr->data = malloc(sizeof(SignalConnection) * arr->capacity);
-        mm_bind(&signal_map, key, arr, sizeof(*arr), true);
+static void signal_table_init(void) {
+    signal_table.capacity = 32;
+    signal_table.count = 1; // handle 0 is SIGNAL_INVALID_HANDLE
+    signal_table.data = calloc(signal_table.capacity, sizeof(SignalEntry));
+}
+
+static void signal_table_free(void) {
+    for (size_t i = 1; i < signal_table.count; ++i) {
+        free(signal_table.data[i].name);
+        free(signal_table.data[i].listeners.data);
+        SignalSenderIndex* senders = &signal_table.data[i].senders;
+        for (uint32_t l = 0; l < senders->count; ++l)
+            free(senders->lists[l].listeners.data);
+        free(senders->lists);
+        free(senders->map);
     }
-    return arr;
+    free(signal_table.data);
+    signal_table.data = NULL;
+    signal_table.count = signal_table.capacity = 0;
+}
+
+static inline SignalEntry* signal_entry(SignalHandle signal) {
+    return (signal != SIGNAL_INVALID_HANDLE && signal < signal_table.count) ? &signal_table.data[signal] : NULL;
+}
+
+static SignalHandle signal_lookup(const char* name) {
+    return (SignalHandle)(uintptr_t)mm_get(&signal_map, STR((char*)name));
+}
+
+static void slot_table_init(void) {
+    slot_table.capacity = 64;
+    slot_table.count = 1; // slot 0 keeps SignalID 0 invalid
+    slot_table.free_head = 0;
+    slot_table.data = calloc(slot_table.capacity, sizeof(SignalSlot));
+}
+
+static void slot_table_free(void) {
+    free(slot_table.data);
+    slot_table.data = NULL;
+    slot_table.count = slot_table.capacity = 0;
+    slot_table.free_head = 0;
+}
+
+static SignalID slot_alloc(SignalHandle signal, uint32_t list, uint32_t index) {
+    uint32_t slot = slot_table.free_head;
+    if (slot) {
+        slot_table.free_head = slot_table.data[slot].next_free;
+    } else {
+        if (slot_table.count >= slot_table.capacity) {
+            size_t new_capacity = slot_table.capacity * 2;
+            SignalSlot* data = realloc(slot_table.data, new_capacity * sizeof(SignalSlot));
+            if (!data)
+                return SIGNAL_INVALID_ID;
+            memset(data + slot_table.capacity, 0, (new_capacity - slot_table.capacity) * sizeof(SignalSlot));
+            slot_table.data = data;
+            slot_table.capacity = new_capacity;
+        }
+        slot = (uint32_t)slot_table.count++;
+        slot_table.data[slot].generation = 1;
+    }
+
+    SignalSlot* s = &slot_table.data[slot];
+    s->signal = signal;
+    s->list = list;
+    s->index = index;
+    s->next_free = 0;
+    return ((SignalID)s->generation << 32) | slot;
+}
+
+static SignalSlot* slot_get(SignalID id) {
+    uint32_t slot = (uint32_t)id;
+    uint32_t generation = (uint32_t)(id >> 32);
+    if (slot == 0 || slot >= slot_table.count)
+        return NULL;
+    SignalSlot* s = &slot_table.data[slot];
+    return (s->generation == generation && s->signal != SIGNAL_INVALID_HANDLE) ? s : NULL;
+}
+
+static void slot_release(SignalID id) {
+    uint32_t slot = (uint32_t)id;
+    SignalSlot* s = &slot_table.data[slot];
+    s->signal = SIGNAL_INVALID_HANDLE;
+    s->generation = (s->generation + 1) & 0x7fffffffu; // the top bit of an id marks patterns
+    if (s->generation == 0)
+        s->generation = 1;
+    s->next_free = slot_table.free_head;
+    slot_table.free_head = slot;
 }
 
-SignalID signal_connection_array_push(SignalConnectionArray* arr, const char* name, SignalCallback cb, void* user_data) {
+SignalID signal_connection_array_push(SignalConnectionArray* arr, SignalHandle signal, uint32_t list, SignalConnection conn) {
     if (arr->count == arr->capacity) {
-        arr->capacity *= 2;
+        arr->capacity = arr->capacity ? arr->capacity * 2 : 4;
         arr->data = realloc(arr->data, arr->capacity * sizeof(SignalConnection));
     }
-    SignalID id = signal_id_counter++;
-    arr->data[arr->count++] = (SignalConnection){id, name, cb, user_data };
-    return id;
+    conn.id = slot_alloc(signal, list, (uint32_t)arr->count);
+    if (conn.id == SIGNAL_INVALID_ID)
+        return conn.id;
+    arr->data[arr->count++] = conn;
+    if (conn.flags & SIGNAL_CONNECT_THREAD_SAFE)
+        arr->thread_safe++;
+    return conn.id;
+}
+
+// Drops tombstones while keeping connection order, and re-points the moved slots
+static void signal_connection_array_compact(SignalConnectionArray* arr) {
+    size_t dst = 0;
+    for (size_t src = 0; src < arr->count; ++src) {
+        SignalConnection* conn = &arr->data[src];
+        if (!conn->callback && !conn->batch_callback)
+            continue;
+        if (dst != src) {
+            arr->data[dst] = *conn;
+            slot_table.data[(uint32_t)conn->id].index = (uint32_t)dst;
+        }
+        dst++;
+    }
+    arr->count = dst;
+    arr->tombstones = 0;
+}
+
+static inline SignalConnectionArray* signal_connection_list(SignalEntry* entry, uint32_t list) {
+    return list ? &entry->senders.lists[list - 1].listeners : &entry->listeners;
+}
+
+static uint32_t sender_index_find(const SignalSenderIndex* index, SignalHandle signal, void* sender) {
+    if (!index->map_capacity)
+        return 0;
+    size_t mask = index->map_capacity - 1;
+    size_t idx = signal_sender_hash(signal, sender) & mask;
+    while (index->map[idx].list) {
+        if (index->map[idx].sender == sender)
+            return index->map[idx].list;
+        idx = (idx + 1) & mask;
+    }
+    return 0;
+}
+
+static void sender_index_insert(SignalSenderIndex* index, SignalHandle signal, void* sender, uint32_t list) {
+    size_t mask = index->map_capacity - 1;
+    size_t idx = signal_sender_hash(signal, sender) & mask;
+    while (index->map[idx].list)
+        idx = (idx + 1) & mask;
+    index->map[idx] = (SignalSenderIndexEntry){ sender, list };
+}
+
+static int sender_index_reserve(SignalSenderIndex* index, SignalHandle signal) {
+    if (index->count == index->capacity) {
+        uint32_t new_capacity = index->capacity ? index->capacity * 2 : 8;
+        SignalSenderListeners* lists = realloc(index->lists, new_capacity * sizeof(SignalSenderListeners));
+        if (!lists)
+            return 0;
+        index->lists = lists;
+        index->capacity = new_capacity;
+    }
+    if ((index->count + 1) * 2 > index->map_capacity) {
+        size_t new_capacity = index->map_capacity ? index->map_capacity * 2 : 16;
+        SignalSenderIndexEntry* map = calloc(new_capacity, sizeof(SignalSenderIndexEntry));
+        if (!map)
+            return 0;
+        free(index->map);
+        index->map = map;
+        index->map_capacity = new_capacity;
+        for (uint32_t l = 0; l < index->count; ++l)
+            sender_index_insert(index, signal, index->lists[l].sender, l + 1);
+    }
+    return 1;
+}
+
+// Returns the sender's list, creating it if needed, or 0 on allocation failure
+static uint32_t sender_index_get(SignalEntry* entry, SignalHandle signal, void* sender) {
+    SignalSenderIndex* index = &entry->senders;
+    uint32_t list = sender_index_find(index, signal, sender);
+    if (list || !sender_index_reserve(index, signal))
+        return list;
+
+    list = ++index->count;
+    index->lists[list - 1] = (SignalSenderListeners){ sender, { 0 } };
+    sender_index_insert(index, signal, sender, list);
+    return list;
+}
+
+// Removes a list, moving the last one into its place
+static void sender_index_remove(SignalSenderIndex* index, SignalHandle signal, uint32_t list) {
+    size_t mask = index->map_capacity - 1;
+    size_t idx = signal_sender_hash(signal, index->lists[list - 1].sender) & mask;
+    while (index->map[idx].list != list)
+        idx = (idx + 1) & mask;
+    index->map[idx].list = 0;
+
+    // Re-insert the rest of the cluster so lookups don't stop at the new hole
+    idx = (idx + 1) & mask;
+    while (index->map[idx].list) {
+        SignalSenderIndexEntry moved = index->map[idx];
+        index->map[idx].list = 0;
+        sender_index_insert(index, signal, moved.sender, moved.list);
+        idx = (idx + 1) & mask;
+    }
+
+    free(index->lists[list - 1].listeners.data);
+    uint32_t last = index->count--;
+    if (list == last)
+        return;
+
+    SignalSenderListeners* dst = &index->lists[list - 1];
+    *dst = index->lists[last - 1];
+    for (size_t i = 0; i < dst->listeners.count; ++i) {
+        SignalConnection* conn = &dst->listeners.data[i];
+        if (conn->callback || conn->batch_callback)
+            slot_table.data[(uint32_t)conn->id].list = list;
+    }
+    idx = signal_sender_hash(signal, dst->sender) & mask;
+    while (index->map[idx].list != last)
+        idx = (idx + 1) & mask;
+    index->map[idx].list = list;
+}
+
+static void signal_maybe_compact(SignalHandle signal) {
+    SignalEntry* entry = &signal_table.data[signal];
+    if (entry->emitting)
+        return;
+
+    SignalConnectionArray* arr = &entry->listeners;
+    if (arr->tombstones && arr->tombstones * 2 >= arr->count)
+        signal_connection_array_compact(arr);
+
+    SignalSenderIndex* senders = &entry->senders;
+    if (!senders->dirty)
+        return;
+    // Backwards, so the list swapped into a removed one has already been visited
+    for (uint32_t list = senders->count; list > 0; --list) {
+        arr = &senders->lists[list - 1].listeners;
+        if (arr->tombstones == arr->count)
+            sender_index_remove(senders, signal, list);
+        else if (arr->tombstones * 2 >= arr->count)
+            signal_connection_array_compact(arr);
+    }
+    senders->dirty = 0;
+}
+
+// ---- Pattern subscriptions ----
+
+// Returns the length of the segment starting at `name` and sets `next` past its separator (NULL at the end)
+static size_t pattern_segment(const char* name, const char** next) {
+    const char* sep = strstr(name, "::");
+    *next = sep ? sep + 2 : NULL;
+    return sep ? (size_t)(sep - name) : strlen(name);
+}
+
+// Wildcards only work as whole segments; `on_*` or `foo*bar` would silently match literally
+static int pattern_valid(const char* pattern) {
+    for (const char* seg = pattern; seg; ) {
+        const char* next;
+        size_t len = pattern_segment(seg, &next);
+        const char* star = memchr(seg, '*', len);
+        if (star && !(len == 1 || (len == 2 && seg[1] == '*')))
+            return 0;
+        seg = next;
+    }
+    return 1;
+}
+
+static SignalPatternNode* pattern_node_child(SignalPatternNode* node, const char* segment, size_t len) {
+    for (uint32_t i = 0; i < node->child_count; i++) {
+        SignalPatternNode* child = &node->children[i];
+        if (strlen(child->segment) == len && memcmp(child->segment, segment, len) == 0)
+            return child;
+    }
+    if (node->child_count == node->child_capacity) {
+        uint32_t new_capacity = node->child_capacity ? node->child_capacity * 2 : 4;
+        SignalPatternNode* children = realloc(node->children, new_capacity * sizeof(SignalPatternNode));
+        if (!children)
+            return NULL;
+        node->children = children;
+        node->child_capacity = new_capacity;
+    }
+    SignalPatternNode* child = &node->children[node->child_count++];
+    memset(child, 0, sizeof(*child));
+    child->segment = strndup(segment, len);
+    return child;
+}
+
+static void pattern_node_free(SignalPatternNode* node) {
+    for (uint32_t i = 0; i < node->child_count; i++)
+        pattern_node_free(&node->children[i]);
+    free(node->children);
+    free(node->patterns);
+    free(node->segment);
+    memset(node, 0, sizeof(*node));
+}
+
+static SignalPatternNode* pattern_node_find(SignalPatternNode* node, const char* pattern, int create) {
+    for (const char* seg = pattern; seg && node; ) {
+        const char* next;
+        size_t len = pattern_segment(seg, &next);
+        if (!create) {
+            SignalPatternNode* found = NULL;
+            for (uint32_t i = 0; i < node->child_count && !found; i++)
+                if (strlen(node->children[i].segment) == len && memcmp(node->children[i].segment, seg, len) == 0)
+                    found = &node->children[i];
+            node = found;
+        } else {
+            node = pattern_node_child(node, seg, len);
+        }
+        seg = next;
+    }
+    return node;
+}
+
+// Collects into `out` the patterns whose trie path matches the name segments from `seg` on
+static void pattern_match(SignalPatternNode* node, const char* seg, uint32_t* out, size_t* count) {
+    if (!seg) {
+        for (uint32_t i = 0; i < node->pattern_count; i++) {
+            SignalPattern* p = &pattern_table.data[node->patterns[i]];
+            if (p->match_stamp != pattern_table.match_stamp) {
+                p->match_stamp = pattern_table.match_stamp;
+                out[(*count)++] = node->patterns[i];
+            }
+        }
+    }
+
+    const char* next = NULL;
+    size_t len = seg ? pattern_segment(seg, &next) : 0;
+    for (uint32_t i = 0; i < node->child_count; i++) {
+        SignalPatternNode* child = &node->children[i];
+        if (strcmp(child->segment, "**") == 0) {
+            // Zero or more segments: try every remaining suffix
+            for (const char* rest = seg; ; ) {
+                pattern_match(child, rest, out, count);
+                if (!rest)
+                    break;
+                pattern_segment(rest, &rest);
+            }
+        } else if (seg && (strcmp(child->segment, "*") == 0 ||
+                           (strlen(child->segment) == len && memcmp(child->segment, seg, len) == 0))) {
+            pattern_match(child, next, out, count);
+        }
+    }
+}
+
+// Matches one pattern against a name directly; used for signals registered before the pattern
+static int pattern_matches(const char* pattern, const char* name) {
+    if (!pattern)
+        return name == NULL;
+
+    const char* pattern_next;
+    size_t pattern_len = pattern_segment(pattern, &pattern_next);
+    if (pattern_len == 2 && memcmp(pattern, "**", 2) == 0) {
+        for (const char* rest = name; ; ) {
+            if (pattern_matches(pattern_next, rest))
+                return 1;
+            if (!rest)
+                return 0;
+            pattern_segment(rest, &rest);
+        }
+    }
+    if (!name)
+        return 0;
+
+    const char* name_next;
+    size_t name_len = pattern_segment(name, &name_next);
+    if (!(pattern_len == 1 && pattern[0] == '*') &&
+        (pattern_len != name_len || memcmp(pattern, name, name_len) != 0))
+        return 0;
+    return pattern_matches(pattern_next, name_next);
+}
+
+static void pattern_attach(uint32_t index, SignalHandle signal) {
+    SignalPattern* p = &pattern_table.data[index];
+    SignalConnectDesc desc = p->desc;
+    desc.signal = NULL;
+    desc.handle = signal;
+    SignalID id = signal_connect_ex(&desc);
+    if (id == SIGNAL_INVALID_ID)
+        return;
+
+    p = &pattern_table.data[index];
+    if (p->attached_count == p->attached_capacity) {
+        size_t new_capacity = p->attached_capacity ? p->attached_capacity * 2 : 8;
+        SignalID* attached = realloc(p->attached, new_capacity * sizeof(SignalID));
+        if (!attached) {
+            signal_disconnect(id);
+            return;
+        }
+        p->attached = attached;
+        p->attached_capacity = new_capacity;
+    }
+    p->attached[p->attached_count++] = id;
+}
+
+// Connects every pattern matching a newly registered signal
+static void pattern_resolve(SignalHandle signal) {
+    if (pattern_table.count <= 1)
+        return;
+
+    uint32_t stack_out[64];
+    size_t max = pattern_table.count;
+    uint32_t* out = max <= 64 ? stack_out : malloc(max * sizeof(uint32_t));
+    if (!out)
+        return;
+
+    size_t count = 0;
+    pattern_table.match_stamp++;
+    pattern_match(&pattern_table.root, signal_table.data[signal].name, out, &count);
+    for (size_t i = 0; i < count; i++)
+        pattern_attach(out[i], signal);
+
+    if (out != stack_out)
+        free(out);
+}
+
+static SignalID pattern_connect(const char* pattern, const SignalConnectDesc* desc) {
+    if (!pattern_valid(pattern))
+        return SIGNAL_INVALID_ID;
+    uint32_t index = pattern_table.free_head;
+    if (index) {
+        pattern_table.free_head = pattern_table.data[index].next_free;
+    } else {
+        if (pattern_table.count >= pattern_table.capacity) {
+            size_t new_capacity = pattern_table.capacity ? pattern_table.capacity * 2 : 16;
+            SignalPattern* data = realloc(pattern_table.data, new_capacity * sizeof(SignalPattern));
+            if (!data)
+                return SIGNAL_INVALID_ID;
+            memset(data + pattern_table.capacity, 0, (new_capacity - pattern_table.capacity) * sizeof(SignalPattern));
+            pattern_table.data = data;
+            pattern_table.capacity = new_capacity;
+            if (pattern_table.count == 0)
+                pattern_table.count = 1; // slot 0 keeps pattern ids distinct from SIGNAL_INVALID_ID
+        }
+        index = (uint32_t)pattern_table.count++;
+        pattern_table.data[index].generation = 1;
+    }
+
+    SignalPatternNode* leaf = pattern_node_find(&pattern_table.root, pattern, 1);
+    if (!leaf) {
+        pattern_table.data[index].next_free = pattern_table.free_head;
+        pattern_table.free_head = index;
+        return SIGNAL_INVALID_ID;
+    }
+    if (leaf->pattern_count == leaf->pattern_capacity) {
+        uint32_t new_capacity = leaf->pattern_capacity ? leaf->pattern_capacity * 2 : 2;
+        uint32_t* patterns = realloc(leaf->patterns, new_capacity * sizeof(uint32_t));
+        if (!patterns) {
+            pattern_table.data[index].next_free = pattern_table.free_head;
+            pattern_table.free_head = index;
+            return SIGNAL_INVALID_ID;
+        }
+        leaf->patterns = patterns;
+        leaf->pattern_capacity = new_capacity;
+    }
+    leaf->patterns[leaf->pattern_count++] = index;
+
+    SignalPattern* p = &pattern_table.data[index];
+    p->pattern = strdup(pattern);
+    p->desc = *desc;
+    p->attached_count = 0;
+    p->next_free = 0;
+    p->match_stamp = 0;
+
+    // Signals registered before the pattern
+    for (SignalHandle signal = 1; signal < signal_table.count; signal++)
+        if (pattern_matches(pattern, signal_table.data[signal].name))
+            pattern_attach(index, signal);
+
+    return SIGNAL_PATTERN_ID_BIT | ((SignalID)pattern_table.data[index].generation << 32) | index;
+}
+
+static void pattern_disconnect(SignalID id) {
+    uint32_t index = (uint32_t)id;
+    uint32_t generation = (uint32_t)(id >> 32) & 0x7fffffffu;
+    if (index == 0 || index >= pattern_table.count)
+        return;
+    SignalPattern* p = &pattern_table.data[index];
+    if (!p->pattern || p->generation != generation)
+        return;
+
+    SignalPatternNode* leaf = pattern_node_find(&pattern_table.root, p->pattern, 0);
+    for (uint32_t i = 0; leaf && i < leaf->pattern_count; i++) {
+        if (leaf->patterns[i] == index) {
+            leaf->patterns[i] = leaf->patterns[--leaf->pattern_count];
+            break;
+        }
+    }
+
+    for (size_t i = 0; i < p->attached_count; i++)
+        signal_disconnect(p->attached[i]);
+
+    p = &pattern_table.data[index];
+    free(p->pattern);
+    free(p->attached);
+    p->pattern = NULL;
+    p->attached = NULL;
+    p->attached_count = p->attached_capacity = 0;
+    p->generation = (p->generation + 1) & 0x7fffffffu;
+    if (p->generation == 0)
+        p->generation = 1;
+    p->next_free = pattern_table.free_head;
+    pattern_table.free_head = index;
+}
+
+static void pattern_table_free(void) {
+    for (size_t i = 1; i < pattern_table.count; i++) {
+        free(pattern_table.data[i].pattern);
+        free(pattern_table.data[i].attached);
+    }
+    free(pattern_table.data);
+    pattern_node_free(&pattern_table.root);
+    memset(&pattern_table, 0, sizeof(pattern_table));
+}
+
+static void thread_queue_registry_lock_acquire(void) {
+    while (atomic_flag_test_and_set_explicit(&thread_queue_registry_lock, memory_order_acquire))
+        thrd_yield();
+}
+
+static void thread_queue_registry_lock_release(void) {
+    atomic_flag_clear_explicit(&thread_queue_registry_lock, memory_order_release);
+}
+
+// tss destructor, on the exiting thread
+static void thread_queue_retire(void* data) {
+    ThreadSignalQueue* q = data;
+    thread_queue = NULL; // a later destructor that defers a signal registers a new queue
+    if (atomic_exchange(&q->state, THREAD_QUEUE_DEAD) == THREAD_QUEUE_ORPHANED)
+        free(q); // shutdown already freed its chunks and dropped it from the registry
+}
+
+static ThreadSignalQueue* thread_queue_get(void) {
+    ThreadSignalQueue* q = thread_queue;
+    if (q) {
+        if (atomic_load(&q->state) != THREAD_QUEUE_ORPHANED)
+            return q;
+        free(q); // left over from before a shutdown
+        thread_queue = NULL;
+    }
+    if (!atomic_load(&thread_queues_open))
+        return NULL;
+
+    q = calloc(1, sizeof(ThreadSignalQueue));
+    if (!q)
+        return NULL;
+    q->head = q->tail = calloc(1, sizeof(ThreadSignalChunk));
+    if (!q->head) {
+        free(q);
+        return NULL;
+    }
+
+    // Append so drain order follows registration order; checked again under the lock so
+    // shutdown either sees the queue or registration sees the registry closed
+    thread_queue_registry_lock_acquire();
+    if (!atomic_load(&thread_queues_open)) {
+        thread_queue_registry_lock_release();
+        free(q->head);
+        free(q);
+        return NULL;
+    }
+    ThreadSignalQueue* last = &thread_queue_registry;
+    while (atomic_load_explicit(&last->next, memory_order_relaxed))
+        last = atomic_load_explicit(&last->next, memory_order_relaxed);
+    atomic_store_explicit(&last->next, q, memory_order_release);
+    if (thread_queue_key_valid)
+        tss_set(thread_queue_key, q);
+    thread_queue_registry_lock_release();
+
+    thread_queue = q;
+    return q;
+}
+
+static ThreadSignal* thread_queue_reserve(ThreadSignalQueue* q) {
+    ThreadSignalChunk* chunk = q->tail;
+    if (!chunk)
+        return NULL;
+    size_t n = atomic_load_explicit(&chunk->count, memory_order_relaxed);
+    if (n == SIGNAL_THREAD_CHUNK) {
+        ThreadSignalChunk* next = calloc(1, sizeof(ThreadSignalChunk));
+        if (!next)
+            return NULL;
+        atomic_store_explicit(&chunk->next, next, memory_order_release);
+        q->tail = chunk = next;
+        n = 0;
+    }
+    return &chunk->items[n];
+}
+
+static void thread_queue_publish(ThreadSignalQueue* q) {
+    ThreadSignalChunk* chunk = q->tail;
+    size_t n = atomic_load_explicit(&chunk->count, memory_order_relaxed);
+    atomic_store_explicit(&chunk->count, n + 1, memory_order_release);
+}
+
+static void thread_signal_push(SignalHandle signal, const char* name, void* sender, void* args,
+                               const void* payload, size_t size) {
+    if (signal == SIGNAL_INVALID_HANDLE && !name)
+        return;
+    ThreadSignalQueue* q = thread_queue_get();
+    if (!q)
+        return;
+
+    atomic_store(&q->busy, 1);
+    if (!atomic_load(&thread_queues_open)) {
+        atomic_store_explicit(&q->busy, 0, memory_order_release);
+        return;
+    }
+
+    ThreadSignal* t = thread_queue_reserve(q);
+    if (t) {
+        t->signal = signal;
+        t->name = name ? strdup(name) : NULL; // the caller's buffer may be gone by the next flush
+        t->sender = sender;
+        t->args = args;
+        t->payload_size = size;
+        t->payload_heap = NULL;
+        if (size > SIGNAL_INLINE_PAYLOAD) {
+            t->payload_heap = malloc(size);
+            if (t->payload_heap)
+                memcpy(t->payload_heap, payload, size);
+        } else if (size) {
+            memcpy(t->payload, payload, size);
+        }
+        if ((!name || t->name) && (size <= SIGNAL_INLINE_PAYLOAD || t->payload_heap))
+            thread_queue_publish(q);
+        else {
+            free(t->name);
+            free(t->payload_heap);
+        }
+    }
+    atomic_store_explicit(&q->busy, 0, memory_order_release);
+}
+
+// Appends one record to the trace, preceded by an ST_NAME record the first time a signal appears
+static void trace_write(SignalTraceKind kind, SignalHandle signal, void* sender, const void* args,
+                        const void* payload, size_t count, size_t stride) {
+    if (signal >= trace.named_capacity) {
+        size_t new_capacity = trace.named_capacity ? trace.named_capacity * 2 : 64;
+        while (new_capacity <= signal)
+            new_capacity *= 2;
+        uint8_t* named = realloc(trace.named, new_capacity);
+        if (!named)
+            return;
+        memset(named + trace.named_capacity, 0, new_capacity - trace.named_capacity);
+        trace.named = named;
+        trace.named_capacity = new_capacity;
+    }
+    if (!trace.named[signal]) {
+        const char* name = signal_table.data[signal].name;
+        SignalTraceRecord r = { .kind = ST_NAME, .signal = signal, .frame = signal_frame, .size = (uint32_t)strlen(name) };
+        fwrite(&r, sizeof(r), 1, trace.file);
+        fwrite(name, 1, r.size, trace.file);
+        trace.named[signal] = 1;
+    }
+
+    SignalTraceRecord r = { .kind = (uint8_t)kind, .signal = signal, .frame = signal_frame,
+                            .count = (uint32_t)count, .stride = (uint32_t)stride,
+                            .sender = (uint64_t)(uintptr_t)sender };
+    if (payload && stride) {
+        r.flags |= ST_PAYLOAD;
+        r.size = (uint32_t)(count * stride);
+    } else if (args) {
+        r.flags |= ST_ARGS_DROPPED;
+    }
+    fwrite(&r, sizeof(r), 1, trace.file);
+    if (r.size)
+        fwrite(payload, 1, r.size, trace.file);
+}
+
+// Queues a deferred signal, applying the signal's coalescing policy. A non-zero `size` copies
+// `payload` into the arena and ignores `args`. The signal is dropped if the queue or the arena
+// cannot grow.
+static void signal_enqueue(SignalQueueArray* q, SignalHandle signal, void* sender, void* args, const void* payload, size_t size) {
+    QueuedSignal* s = NULL;
+    if (trace.file && dispatch_depth == 0)
+        trace_write(ST_DEFERRED, signal, sender, args, payload, 1, size);
+    SignalCoalesce policy = signal_table.data[signal].coalesce;
+    SignalCoalesceEntry* e = policy != SIGNAL_COALESCE_ALL ? signal_coalesce_find(q, signal, sender) : NULL;
+    bool coalesced = e && e->index != SIZE_MAX;
+    if (coalesced && policy == SIGNAL_COALESCE_FIRST) {
+        signal_table.data[signal].stats.deferred++;
+        signal_table.data[signal].stats.coalesced++;
+        return;
+    }
+
+    // Reserve the payload first so a failure leaves the queue untouched
+    size_t offset = size ? signal_arena_alloc(q, size) : 0;
+    if (offset == SIZE_MAX)
+        return;
+    if (coalesced) {
+        s = &q->data[e->index]; // LATEST: overwrite in place; the old payload bytes are simply abandoned
+        s->args = args;
+        s->payload_size = 0;
+        signal_table.data[signal].stats.coalesced++;
+    } else {
+        s = signal_queue_push(q, signal, sender, args);
+        if (!s)
+            return;
+        if (e)
+            e->index = q->count - 1;
+    }
+    signal_table.data[signal].stats.deferred++;
+
+    if (size) {
+        memcpy(q->arena + offset, payload, size);
+        s->args = NULL;
+        s->payload_offset = offset;
+        s->payload_size = size;
+    }
+}
+
+// Moves everything other threads have published into the main queue and frees the queues of
+// threads that have exited (main thread only)
+static void thread_queues_drain(SignalQueueArray* dst) {
+    ThreadSignalQueue* prev = &thread_queue_registry;
+    for (ThreadSignalQueue* q = atomic_load_explicit(&prev->next, memory_order_acquire); q;
+         q = atomic_load_explicit(&prev->next, memory_order_acquire)) {
+        // Read before draining: a dead queue's last publish happened before it was marked
+        int dead = atomic_load_explicit(&q->state, memory_order_acquire) == THREAD_QUEUE_DEAD;
+        ThreadSignalChunk* chunk = q->head;
+        while (chunk) {
+            size_t n = atomic_load_explicit(&chunk->count, memory_order_acquire);
+            for (size_t i = chunk->read; i < n; ++i) {
+                ThreadSignal* t = &chunk->items[i];
+                SignalHandle signal = t->name ? signal_register(t->name) : t->signal;
+                if (signal_entry(signal))
+                    signal_enqueue(dst, signal, t->sender, t->args,
+                                   t->payload_heap ? t->payload_heap : t->payload, t->payload_size);
+                free(t->name);
+                free(t->payload_heap);
+            }
+            chunk->read = n;
+
+            if (n < SIGNAL_THREAD_CHUNK)
+                break;
+            ThreadSignalChunk* next = atomic_load_explicit(&chunk->next, memory_order_acquire);
+            if (!next)
+                break;
+            free(chunk); // the producer moved on to `next` before publishing it
+            q->head = chunk = next;
+        }
+
+        if (dead) {
+            thread_queue_registry_lock_acquire();
+            atomic_store_explicit(&prev->next, atomic_load_explicit(&q->next, memory_order_relaxed), memory_order_relaxed);
+            thread_queue_registry_lock_release();
+            free(q->head);
+            free(q);
+        } else {
+            prev = q;
+        }
+    }
+}
+
+// Starts accepting pushes (main thread, from init). Without a tss key queues still work, but
+// are only freed at shutdown.
+static void thread_queues_start(void) {
+    thread_queue_key_valid = tss_create(&thread_queue_key, thread_queue_retire) == thrd_success;
+    atomic_store(&thread_queues_open, true);
+}
+
+// Stops accepting pushes, waits out producers already past the check, then frees every chunk
+// and every queue whose thread has exited
+static void thread_queues_stop(void) {
+    atomic_store(&thread_queues_open, false);
+    thread_queue_registry_lock_acquire();
+    ThreadSignalQueue* q = atomic_load_explicit(&thread_queue_registry.next, memory_order_relaxed);
+    atomic_store_explicit(&thread_queue_registry.next, NULL, memory_order_relaxed);
+    thread_queue_registry_lock_release();
+    if (thread_queue_key_valid) {
+        tss_delete(thread_queue_key); // the destructor lives in this module, which may be unloaded next
+        thread_queue_key_valid = 0;
+    }
+
+    while (q) {
+        ThreadSignalQueue* next_queue = atomic_load_explicit(&q->next, memory_order_relaxed);
+        while (atomic_load(&q->busy))
+            thrd_yield();
+
+        ThreadSignalChunk* chunk = q->head;
+        while (chunk) {
+            size_t n = atomic_load_explicit(&chunk->count, memory_order_acquire);
+            for (size_t i = chunk->read; i < n; ++i) {
+                free(chunk->items[i].name);
+                free(chunk->items[i].payload_heap);
+            }
+            ThreadSignalChunk* next = atomic_load_explicit(&chunk->next, memory_order_acquire);
+            free(chunk);
+            chunk = next;
+        }
+        q->head = q->tail = NULL;
+        if (atomic_exchange(&q->state, THREAD_QUEUE_ORPHANED) == THREAD_QUEUE_DEAD)
+            free(q);
+        q = next_queue;
+    }
+}
+
+static inline void signal_call(CoreContext* ctx, const SignalConnection* conn, const SignalEvent* events, size_t count) {
+    if (conn->batch_callback) {
+        conn->batch_callback(ctx, events, count, conn->user_data);
+        return;
+    }
+    for (size_t e = 0; e < count; e++)
+        conn->callback(ctx, events[e].sender, events[e].args, conn->user_data);
+}
+
+// Claims and runs chunks until none are left
+static void signal_parallel_work(SignalParallelEmit* job) {
+    for (;;) {
+        size_t chunk = atomic_fetch_add_explicit(&job->next_chunk, 1, memory_order_relaxed);
+        if (chunk >= job->chunks)
+            return;
+        size_t begin = chunk * job->chunk_size;
+        size_t end = begin + job->chunk_size < job->conn_count ? begin + job->chunk_size : job->conn_count;
+        for (size_t i = begin; i < end; i++)
+            signal_call(job->ctx, &job->conns[i], job->events, job->count);
+    }
+}
+
+static int signal_parallel_entry(void* arg) {
+    signal_parallel_work(arg);
+    return 0;
+}
+
+// Snapshots the thread-safe listeners of `arr` and starts helper jobs on them, or returns NULL
+static SignalParallelEmit* signal_parallel_begin(CoreContext* ctx, const SignalConnectionArray* arr, const SignalEvent* events, size_t count) {
+    SignalParallelEmit* job = malloc(sizeof(SignalParallelEmit) + arr->thread_safe * sizeof(SignalConnection));
+    if (!job)
+        return NULL;
+
+    size_t n = 0;
+    for (size_t i = 0; i < arr->count; i++) {
+        const SignalConnection* conn = &arr->data[i];
+        if ((conn->flags & SIGNAL_CONNECT_THREAD_SAFE) && (conn->callback || conn->batch_callback))
+            job->conns[n++] = *conn;
+    }
+
+    size_t chunks = (size_t)(parallel_helpers + 1) * SIGNAL_PARALLEL_CHUNKS;
+    job->chunk_size = (n + chunks - 1) / chunks;
+    job->chunks = (n + job->chunk_size - 1) / job->chunk_size;
+    job->conn_count = n;
+    job->ctx = ctx;
+    job->events = events;
+    job->count = count;
+    atomic_init(&job->next_chunk, 0);
+
+    // A helper the pool could not take (JOB_INVALID_HANDLE) just leaves its chunks to the others
+    for (int i = 0; i < parallel_helpers; i++)
+        job->helpers[i] = thread_spawn_fn(signal_parallel_entry, job);
+    return job;
+}
+
+static void signal_parallel_end(SignalParallelEmit* job) {
+    signal_parallel_work(job);
+    // Every chunk is claimed; waiting helps run whatever is still queued instead of spinning
+    for (int i = 0; i < parallel_helpers; i++)
+        thread_job_wait_fn(job->helpers[i], NULL);
+    free(job);
+}
+
+#ifdef SIGNAL_PROFILE_LISTENERS
+// Per-listener counters live in a side table keyed by connection id, so SignalConnection has the
+// same layout whether or not a build profiles listeners
+typedef struct {
+    SignalID id;                      // SIGNAL_INVALID_ID marks an empty slot
+    uint64_t calls;                   // dispatches that ran the listener (a batch counts once)
+    uint64_t total_ns;                // time spent in the listener while timing is on
+    uint64_t worst_ns;                // longest single invocation while timing is on
+} SignalListenerProfile;
+
+static struct {
+    SignalListenerProfile* data;      // open addressing, power of two sized
+    size_t count;
+    size_t capacity;
+} listener_profiles;
+
+static size_t listener_profile_home(SignalID id, size_t mask) {
+    return (size_t)(id * 11400714819323198485ull) & mask;
+}
+
+static SignalListenerProfile* listener_profile(SignalID id, int create) {
+    if (create && (listener_profiles.count + 1) * 2 > listener_profiles.capacity) {
+        size_t new_capacity = listener_profiles.capacity ? listener_profiles.capacity * 2 : 64;
+        SignalListenerProfile* data = calloc(new_capacity, sizeof(SignalListenerProfile));
+        if (!data)
+            return NULL;
+        for (size_t i = 0; i < listener_profiles.capacity; i++) {
+            SignalListenerProfile* p = &listener_profiles.data[i];
+            if (p->id == SIGNAL_INVALID_ID)
+                continue;
+            size_t idx = listener_profile_home(p->id, new_capacity - 1);
+            while (data[idx].id != SIGNAL_INVALID_ID)
+                idx = (idx + 1) & (new_capacity - 1);
+            data[idx] = *p;
+        }
+        free(listener_profiles.data);
+        listener_profiles.data = data;
+        listener_profiles.capacity = new_capacity;
+    }
+    if (!listener_profiles.capacity)
+        return NULL;
+
+    size_t mask = listener_profiles.capacity - 1;
+    size_t idx = listener_profile_home(id, mask);
+    while (listener_profiles.data[idx].id != id) {
+        if (listener_profiles.data[idx].id == SIGNAL_INVALID_ID) {
+            if (!create)
+                return NULL;
+            listener_profiles.data[idx].id = id;
+            listener_profiles.count++;
+            break;
+        }
+        idx = (idx + 1) & mask;
+    }
+    return &listener_profiles.data[idx];
+}
+
+// Drops a disconnected listener's counters, shifting later entries of its probe run back so
+// lookups never stop at the hole
+static void listener_profile_remove(SignalID id) {
+    SignalListenerProfile* p = listener_profile(id, 0);
+    if (!p)
+        return;
+    size_t mask = listener_profiles.capacity - 1;
+    size_t hole = (size_t)(p - listener_profiles.data);
+    for (size_t idx = (hole + 1) & mask; listener_profiles.data[idx].id != SIGNAL_INVALID_ID; idx = (idx + 1) & mask) {
+        size_t home = listener_profile_home(listener_profiles.data[idx].id, mask);
+        if (((idx - home) & mask) >= ((idx - hole) & mask)) {
+            listener_profiles.data[hole] = listener_profiles.data[idx];
+            hole = idx;
+        }
+    }
+    memset(&listener_profiles.data[hole], 0, sizeof(SignalListenerProfile));
+    listener_profiles.count--;
+}
+
+static void listener_profiles_free(void) {
+    free(listener_profiles.data);
+    memset(&listener_profiles, 0, sizeof(listener_profiles));
+}
+
+static void signal_profile_listener(SignalHandle signal, uint32_t list, size_t i, uint64_t start) {
+    SignalConnection* conn = &signal_connection_list(&signal_table.data[signal], list)->data[i];
+    SignalListenerProfile* p = listener_profile(conn->id, 1);
+    if (!p)
+        return;
+    p->calls++;
+    if (start) {
+        uint64_t ns = dt_now_ns() - start;
+        p->total_ns += ns;
+        if (ns > p->worst_ns)
+            p->worst_ns = ns;
+    }
+}
+#endif
+
+// Runs the listeners of one connection list over the span; batch listeners get it in a single call.
+// Returns the number of listeners run and adds the number of invocations to `calls`.
+static size_t signal_invoke(CoreContext* ctx, SignalHandle signal, uint32_t list, const SignalEvent* events, size_t count, uint64_t* calls) {
+    SignalConnectionArray* arr = signal_connection_list(&signal_table.data[signal], list);
+    SignalParallelEmit* parallel = NULL;
+    size_t fan_out = 0;
+    if (parallel_helpers && parallel_threshold && arr->thread_safe >= parallel_threshold) {
+        parallel = signal_parallel_begin(ctx, arr, events, count);
+        if (parallel) {
+            fan_out += parallel->conn_count;
+            *calls += parallel->conn_count * count; // batch listeners are counted per event here
+        }
+    }
+
+    // Connections added by a listener are appended past `listeners` and skipped by this emit;
+    // disconnections only leave tombstones until the outermost emit finishes.
+    size_t listeners = arr->count;
+
+    // Re-index every iteration: a listener may register signals and move the table
+    for (size_t i = 0; i < listeners; i++) {
+        SignalConnection conn = signal_connection_list(&signal_table.data[signal], list)->data[i];
+        if (parallel && (conn.flags & SIGNAL_CONNECT_THREAD_SAFE))
+            continue;
+        if (!conn.callback && !conn.batch_callback)
+            continue;
+#ifdef SIGNAL_PROFILE_LISTENERS
+        uint64_t start = stats_timing ? dt_now_ns() : 0;
+#endif
+        fan_out++;
+        if (conn.batch_callback) {
+            conn.batch_callback(ctx, events, count, conn.user_data);
+            (*calls)++;
+        } else {
+            for (size_t e = 0; e < count && conn.callback; e++) {
+                conn.callback(ctx, events[e].sender, events[e].args, conn.user_data);
+                (*calls)++;
+                // Stop early if the listener disconnected itself
+                conn.callback = signal_connection_list(&signal_table.data[signal], list)->data[i].callback;
+            }
+        }
+#ifdef SIGNAL_PROFILE_LISTENERS
+        signal_profile_listener(signal, list, i, start);
+#endif
+    }
+
+    if (parallel)
+        signal_parallel_end(parallel);
+    return fan_out;
+}
+
+// Runs the wildcard listeners over the span, then the listeners of each event's sender
+static void signal_dispatch(CoreContext* ctx, SignalHandle signal, const SignalEvent* events, size_t count) {
+    if (!signal_entry(signal) || count == 0) return;
+
+    uint64_t start = stats_timing ? dt_now_ns() : 0;
+    uint64_t calls = 0;
+    size_t fan_out = 0;
+    dispatch_depth++;
+
+    // Sender lists created by a listener are skipped by this emit
+    uint32_t sender_lists = signal_table.data[signal].senders.count;
+    signal_table.data[signal].emitting++;
+
+    fan_out += signal_invoke(ctx, signal, 0, events, count, &calls);
+    for (size_t e = 0; e < count && sender_lists; ) {
+        size_t run = 1;
+        while (e + run < count && events[e + run].sender == events[e].sender)
+            run++;
+        uint32_t list = sender_index_find(&signal_table.data[signal].senders, signal, events[e].sender);
+        if (list && list <= sender_lists)
+            fan_out += signal_invoke(ctx, signal, list, events + e, run, &calls);
+        e += run;
+    }
+
+    SignalStats* stats = &signal_table.data[signal].stats;
+    stats->emits += count;
+    stats->dispatches++;
+    stats->listener_calls += calls;
+    stats->last_fan_out = (uint32_t)fan_out;
+    if (fan_out > stats->max_fan_out)
+        stats->max_fan_out = (uint32_t)fan_out;
+    if (start) {
+        uint64_t ns = dt_now_ns() - start;
+        stats->total_ns += ns;
+        if (ns > stats->worst_ns)
+            stats->worst_ns = ns;
+    }
+
+    dispatch_depth--;
+    signal_table.data[signal].emitting--;
+    signal_maybe_compact(signal);
+}
+
+static int flush_scratch_reserve(size_t events, size_t groups) {
+    if (events > flush_scratch.events_capacity) {
+        size_t capacity = flush_scratch.events_capacity ? flush_scratch.events_capacity : 64;
+        while (capacity < events)
+            capacity *= 2;
+        SignalEvent* data = realloc(flush_scratch.events, capacity * sizeof(SignalEvent));
+        if (!data)
+            return 0;
+        flush_scratch.events = data;
+        flush_scratch.events_capacity = capacity;
+    }
+    if (groups > flush_scratch.groups_capacity) {
+        size_t capacity = flush_scratch.groups_capacity ? flush_scratch.groups_capacity : 16;
+        while (capacity < groups)
+            capacity *= 2;
+        void* data = realloc(flush_scratch.groups, capacity * sizeof(*flush_scratch.groups));
+        if (!data)
+            return 0;
+        flush_scratch.groups = data;
+        flush_scratch.groups_capacity = capacity;
+    }
+    return 1;
 }
 
 void signal_flush(CoreContext* ctx) {
-    for (size_t i = 0; i < signal_queue.count; i++) {
-        QueuedSignal* s = &signal_queue.data[i];
-        signal_emit(ctx, s->name, s->sender, s->args);
+    // A listener flushing again would swap the queues and reuse the scratch arrays under the
+    // outer flush; other threads never own the queues
+    if (flushing || !is_main_thread)
+        return;
+    flushing = 1;
+    thread_queues_drain(&signal_queues[signal_queue_active]);
+
+    SignalQueueArray* q = &signal_queues[signal_queue_active];
+    signal_queue_active ^= 1;
+
+    if (!flush_scratch_reserve(q->count, 0)) {
+        signal_queue_clear(q);
+        flushing = 0;
+        return;
     }
-    signal_queue_clear(&signal_queue);
+
+    // Counting sort by signal: stable within a signal, signals in order of first appearance
+    size_t group_count = 0;
+    for (size_t i = 0; i < q->count; i++) {
+        SignalEntry* entry = &signal_table.data[q->data[i].signal];
+        if (entry->flush_count == 0) {
+            if (!flush_scratch_reserve(0, group_count + 1))
+                continue;
+            flush_scratch.groups[group_count].signal = q->data[i].signal;
+            group_count++;
+        }
+        entry->flush_count++;
+    }
+    size_t offset = 0;
+    flush_stats.last_depth = (uint32_t)q->count;
+    if (flush_stats.last_depth > flush_stats.max_depth)
+        flush_stats.max_depth = flush_stats.last_depth;
+    for (size_t g = 0; g < group_count; g++) {
+        SignalEntry* entry = &signal_table.data[flush_scratch.groups[g].signal];
+        flush_scratch.groups[g].count = entry->flush_count;
+        entry->stats.last_flush_depth = (uint32_t)entry->flush_count;
+        if (entry->stats.last_flush_depth > entry->stats.max_flush_depth)
+            entry->stats.max_flush_depth = entry->stats.last_flush_depth;
+        entry->flush_offset = offset;
+        offset += entry->flush_count;
+    }
+    for (size_t i = 0; i < q->count; i++) {
+        QueuedSignal* s = &q->data[i];
+        SignalEntry* entry = &signal_table.data[s->signal];
+        if (entry->flush_count == 0)
+            continue;
+        void* args = s->payload_size ? q->arena + s->payload_offset : s->args;
+        flush_scratch.events[entry->flush_offset++] = (SignalEvent){ s->sender, args };
+    }
+    for (size_t g = 0; g < group_count; g++) {
+        SignalEntry* entry = &signal_table.data[flush_scratch.groups[g].signal];
+        entry->flush_count = 0;
+        entry->flush_offset = 0;
+    }
+
+    // Listeners may move the signal table or defer more signals (into the other queue),
+    // so dispatch only walks the scratch arrays
+    offset = 0;
+    for (size_t g = 0; g < group_count; g++) {
+        signal_dispatch(ctx, flush_scratch.groups[g].signal, flush_scratch.events + offset, flush_scratch.groups[g].count);
+        offset += flush_scratch.groups[g].count;
+    }
+    signal_frame++;
+    signal_queue_clear(q);
+    flushing = 0;
 }
 
 // PUBLIC METHODS
 
+SignalHandle signal_register(const char* name) {
+    SignalHandle signal = signal_lookup(name);
+    if (signal != SIGNAL_INVALID_HANDLE)
+        return signal;
+
+    if (signal_table.count >= signal_table.capacity) {
+        size_t new_capacity = signal_table.capacity * 2;
+        SignalEntry* data = realloc(signal_table.data, new_capacity * sizeof(SignalEntry));
+        if (!data)
+            return SIGNAL_INVALID_HANDLE;
+        memset(data + signal_table.capacity, 0, (new_capacity - signal_table.capacity) * sizeof(SignalEntry));
+        signal_table.data = data;
+        signal_table.capacity = new_capacity;
+    }
+
+    signal = (SignalHandle)signal_table.count++;
+    SignalEntry* entry = &signal_table.data[signal];
+    entry->name = strdup(name);
+    mm_bind(&signal_map, STR(entry->name), (void*)(uintptr_t)signal, 0, false);
+    pattern_resolve(signal);
+    return signal;
+}
+
+SignalHandle signal_register_coalesced(const char* name, SignalCoalesce policy) {
+    SignalHandle signal = signal_register(name);
+    SignalEntry* entry = signal_entry(signal);
+    if (entry)
+        entry->coalesce = policy;
+    return signal;
+}
+
+SignalID signal_connect_ex(const SignalConnectDesc* desc) {
+    if (!desc || !desc->callback == !desc->batch_callback)
+        return SIGNAL_INVALID_ID;
+
+    SignalHandle signal = desc->handle != SIGNAL_INVALID_HANDLE ? desc->handle
+                        : desc->signal ? signal_register(desc->signal) : SIGNAL_INVALID_HANDLE;
+    SignalEntry* entry = signal_entry(signal);
+    if (!entry)
+        return SIGNAL_INVALID_ID;
+
+    uint32_t list = 0;
+    if (desc->flags & SIGNAL_CONNECT_FROM_SENDER) {
+        list = sender_index_get(entry, signal, desc->sender);
+        if (!list)
+            return SIGNAL_INVALID_ID;
+    }
+
+    SignalConnection conn = { .signal_name = entry->name, .callback = desc->callback, .batch_callback = desc->batch_callback,
+                              .user_data = desc->user_data, .flags = desc->flags };
+    return signal_connection_array_push(signal_connection_list(entry, list), signal, list, conn);
+}
+
+SignalID signal_connect_id(SignalHandle signal, SignalCallback cb, void* user_data) {
+    SignalConnectDesc desc = { .handle = signal, .callback = cb, .user_data = user_data };
+    return signal_connect_ex(&desc);
+}
+
+SignalID signal_connect_from_id(SignalHandle signal, void* sender, SignalCallback cb, void* user_data) {
+    SignalConnectDesc desc = { .handle = signal, .callback = cb, .user_data = user_data,
+                               .sender = sender, .flags = SIGNAL_CONNECT_FROM_SENDER };
+    return signal_connect_ex(&desc);
+}
+
+SignalID signal_connect_from(const char* name, void* sender, SignalCallback cb, void* user_data) {
+    return signal_connect_from_id(signal_register(name), sender, cb, user_data);
+}
+
+SignalID signal_connect_batch_id(SignalHandle signal, SignalBatchCallback cb, void* user_data) {
+    SignalConnectDesc desc = { .handle = signal, .batch_callback = cb, .user_data = user_data };
+    return signal_connect_ex(&desc);
+}
+
+SignalID signal_connect_batch(const char* name, SignalBatchCallback cb, void* user_data) {
+    return signal_connect_batch_id(signal_register(name), cb, user_data);
+}
+
+void signal_set_parallel_threshold(size_t threshold) {
+    parallel_threshold = threshold;
+}
+
 SignalID signal_connect(const char* name, SignalCallback cb, void* user_data) {
-    SignalConnectionArray* arr = get_or_create_signal_array(name);
-    return signal_connection_array_push(arr, name, cb, user_data);
+    SignalConnectDesc desc = { .signal = name, .callback = cb, .user_data = user_data };
+    return signal_connect_ex(&desc);
+}
+
+SignalID signal_connect_pattern(const char* pattern, SignalCallback cb, void* user_data) {
+    SignalConnectDesc desc = { .signal = pattern, .callback = cb, .user_data = user_data };
+    if (!pattern || !cb)
+        return SIGNAL_INVALID_ID;
+    return pattern_connect(pattern, &desc);
 }
 
 void signal_disconnect(SignalID id)
 {
-    for (size_t b = 0; b < signal_map.capacity; ++b)
-    {
-        MemoryBucket* bucket = &signal_map.buckets[b];
-        for (size_t e = 0; e < bucket->count; ++e)
-        {
-            MemoryEntry* entry = &bucket->entries[e];
-            if (!entry->data) continue;
-
-            SignalConnectionArray* arr = (SignalConnectionArray*)entry->data;
-            for (size_t i = 0; i < arr->count; ++i)
-            {
-                if (arr->data[i].id == id)
-                {
-                    // Remove connection by shifting the rest
-                    memmove(&arr->data[i], &arr->data[i + 1], (arr->count - i - 1) * sizeof(SignalConnection));
-                    arr->count--;
-                    return;
-                }
-            }
-        }
+    if (id & SIGNAL_PATTERN_ID_BIT) {
+        pattern_disconnect(id);
+        return;
     }
+
+    SignalSlot* slot = slot_get(id);
+    if (!slot)
+        return;
+
+    SignalHandle signal = slot->signal;
+    SignalEntry* entry = &signal_table.data[signal];
+    SignalConnectionArray* arr = signal_connection_list(entry, slot->list);
+    if (arr->data[slot->index].flags & SIGNAL_CONNECT_THREAD_SAFE)
+        arr->thread_safe--;
+    arr->data[slot->index].callback = NULL;
+    arr->data[slot->index].batch_callback = NULL;
+    arr->tombstones++;
+    if (slot->list)
+        entry->senders.dirty = 1;
+    slot_release(id);
+#ifdef SIGNAL_PROFILE_LISTENERS
+    listener_profile_remove(id);
+#endif
+
+    signal_maybe_compact(signal);
+}
+
+void signal_emit_id(CoreContext* ctx, SignalHandle signal, void* sender, void* args) {
+    if (trace.file && dispatch_depth == 0 && signal_entry(signal))
+        trace_write(ST_EMIT, signal, sender, args, NULL, 1, 0);
+    SignalEvent event = { sender, args };
+    signal_dispatch(ctx, signal, &event, 1);
 }
 
 void signal_emit(CoreContext* ctx, const char* name, void* sender, void* args) {
-    SignalConnectionArray* arr = mm_get(&signal_map, STR((char*)name));
-    if (!arr) return;
+    signal_emit_id(ctx, signal_lookup(name), sender, args);
+}
 
-    for (size_t i = 0; i < arr->count; i++) {
-        SignalConnection* conn = &arr->data[i];
-        conn->callback(ctx, sender, args, conn->user_data);
+void signal_emit_batch_id(CoreContext* ctx, SignalHandle signal, void* sender, void* args_array, size_t count, size_t stride) {
+    if (!signal_entry(signal) || count == 0) return;
+    if (trace.file && dispatch_depth == 0)
+        trace_write(ST_EMIT, signal, sender, args_array, args_array, count, stride);
+
+    SignalEvent stack_events[SIGNAL_BATCH_STACK];
+    SignalEvent* events = count <= SIGNAL_BATCH_STACK ? stack_events : malloc(count * sizeof(SignalEvent));
+    if (!events) return;
+
+    for (size_t i = 0; i < count; i++)
+        events[i] = (SignalEvent){ sender, args_array ? (char*)args_array + i * stride : NULL };
+    signal_dispatch(ctx, signal, events, count);
+
+    if (events != stack_events)
+        free(events);
+}
+
+void signal_emit_batch(CoreContext* ctx, const char* name, void* sender, void* args_array, size_t count, size_t stride) {
+    signal_emit_batch_id(ctx, signal_lookup(name), sender, args_array, count, stride);
+}
+
+void signal_emit_deferred_id(SignalHandle signal, void* sender, void* args) {
+    if (!is_main_thread) {
+        thread_signal_push(signal, NULL, sender, args, NULL, 0);
+        return;
+    }
+    if (!signal_entry(signal)) return;
+    signal_enqueue(&signal_queues[signal_queue_active], signal, sender, args, NULL, 0);
+}
+
+void signal_emit_deferred_copy(SignalHandle signal, void* sender, const void* payload, size_t size) {
+    if (!is_main_thread) {
+        thread_signal_push(signal, NULL, sender, NULL, payload, size);
+        return;
     }
+    if (!signal_entry(signal)) return;
+    signal_enqueue(&signal_queues[signal_queue_active], signal, sender, NULL, payload, size);
 }
 
 void signal_emit_deferred(const char* name, void* sender, void* args) {
-    signal_queue_push(&signal_queue, name, sender, args);
+    if (!is_main_thread) {
+        // The name is resolved on the main thread while draining
+        thread_signal_push(SIGNAL_INVALID_HANDLE, name, sender, args, NULL, 0);
+        return;
+    }
+    // Registered so that listeners connecting before the flush still receive it
+    signal_emit_deferred_id(signal_register(name), sender, args);
+}
+
+const SignalStats* signal_stats(SignalHandle signal) {
+    SignalEntry* entry = signal_entry(signal);
+    return entry ? &entry->stats : NULL;
+}
+
+static int signal_stats_compare(const void* a, const void* b) {
+    const SignalStats* sa = &signal_table.data[*(const SignalHandle*)a].stats;
+    const SignalStats* sb = &signal_table.data[*(const SignalHandle*)b].stats;
+    if (sa->total_ns != sb->total_ns)
+        return sa->total_ns < sb->total_ns ? 1 : -1;
+    if (sa->listener_calls != sb->listener_calls)
+        return sa->listener_calls < sb->listener_calls ? 1 : -1;
+    return 0;
+}
+
+#ifdef SIGNAL_PROFILE_LISTENERS
+static const SignalConnection* signal_slowest_listener(SignalEntry* entry, const SignalListenerProfile** profile) {
+    const SignalConnection* slowest = NULL;
+    for (uint32_t list = 0; list <= entry->senders.count; list++) {
+        SignalConnectionArray* arr = signal_connection_list(entry, list);
+        for (size_t i = 0; i < arr->count; i++) {
+            const SignalConnection* conn = &arr->data[i];
+            const SignalListenerProfile* p = conn->callback || conn->batch_callback ? listener_profile(conn->id, 0) : NULL;
+            if (p && p->calls && (!slowest || p->worst_ns > (*profile)->worst_ns)) {
+                slowest = conn;
+                *profile = p;
+            }
+        }
+    }
+    return slowest;
+}
+#endif
+
+void signal_stats_dump(CoreContext* ctx) {
+    SignalHandle* order = malloc(signal_table.count * sizeof(SignalHandle));
+    if (!order)
+        return;
+    size_t count = 0;
+    for (SignalHandle signal = 1; signal < signal_table.count; signal++)
+        if (signal_table.data[signal].stats.dispatches || signal_table.data[signal].stats.deferred)
+            order[count++] = signal;
+    qsort(order, count, sizeof(SignalHandle), signal_stats_compare);
+
+    CC_LOG_INFO(ctx, "[signals] %zu active signals, flush depth %u (max %u)%s",
+                count, flush_stats.last_depth, flush_stats.max_depth, stats_timing ? "" : ", timing off");
+    for (size_t i = 0; i < count; i++) {
+        const SignalEntry* entry = &signal_table.data[order[i]];
+        const SignalStats* st = &entry->stats;
+        CC_LOG_INFO(ctx, "[signals] %-32s emits %-8llu deferred %-8llu coalesced %-6llu depth %u/%u fan-out %u/%u calls %-8llu total %.3f ms worst %.1f us",
+                    entry->name, (unsigned long long)st->emits, (unsigned long long)st->deferred,
+                    (unsigned long long)st->coalesced, st->last_flush_depth, st->max_flush_depth,
+                    st->last_fan_out, st->max_fan_out, (unsigned long long)st->listener_calls,
+                    st->total_ns / 1e6, st->worst_ns / 1e3);
+#ifdef SIGNAL_PROFILE_LISTENERS
+        const SignalListenerProfile* profile = NULL;
+        const SignalConnection* slowest = signal_slowest_listener(&signal_table.data[order[i]], &profile);
+        if (slowest)
+            CC_LOG_INFO(ctx, "[signals]     slowest listener %p (id %llu): calls %llu total %.3f ms worst %.1f us",
+                        slowest->callback ? (void*)(uintptr_t)slowest->callback : (void*)(uintptr_t)slowest->batch_callback,
+                        (unsigned long long)slowest->id, (unsigned long long)profile->calls,
+                        profile->total_ns / 1e6, profile->worst_ns / 1e3);
+#endif
+    }
+    free(order);
+}
+
+void signal_stats_configure(int timing, float dump_interval) {
+    stats_interval = dump_interval > 0.0f ? dump_interval : 0.0f;
+    stats_timing = timing || stats_interval > 0.0f;
+    stats_elapsed = 0.0f;
+}
+
+void signal_stats_reset(void) {
+    for (SignalHandle signal = 1; signal < signal_table.count; signal++) {
+        SignalEntry* entry = &signal_table.data[signal];
+        memset(&entry->stats, 0, sizeof(entry->stats));
+    }
+#ifdef SIGNAL_PROFILE_LISTENERS
+    listener_profiles_free();
+#endif
+    memset(&flush_stats, 0, sizeof(flush_stats));
+}
+
+int signal_record_start(const char* path) {
+    signal_record_stop();
+    trace.file = fopen(path, "wb");
+    if (!trace.file)
+        return 1;
+    setvbuf(trace.file, NULL, _IOFBF, 1 << 16);
+
+    SignalTraceFileHeader header = { SIGNAL_TRACE_MAGIC, SIGNAL_TRACE_VERSION, sizeof(SignalTraceRecord) };
+    fwrite(&header, sizeof(header), 1, trace.file);
+    return 0;
+}
+
+void signal_record_stop(void) {
+    if (trace.file)
+        fclose(trace.file);
+    free(trace.named);
+    memset(&trace, 0, sizeof(trace));
 }
 
 // PLUGIN API
 
 int init(CoreContext* ctx) {
     mm_init(&signal_map, 32, malloc, free, mm_hash_default);
-    signal_queue_init(&signal_queue);
+    signal_table_init();
+    slot_table_init();
+    signal_queue_init(&signal_queues[0]);
+    signal_queue_init(&signal_queues[1]);
+    signal_queue_active = 0;
+    flushing = 0;
+    is_main_thread = 1; // plugins are initialized on the main thread
+    thread_queues_start();
+    thread_spawn_fn = CC_GET(ctx, CC_THREAD_SPAWN); // NULL without the Threads plugin
+    thread_job_wait_fn = CC_GET(ctx, CC_THREAD_JOB_WAIT);
+    thread_worker_count_fn_t worker_count = CC_GET(ctx, CC_THREAD_WORKER_COUNT);
+    parallel_helpers = thread_spawn_fn && thread_job_wait_fn && worker_count ? worker_count() : 0;
+    if (parallel_helpers > SIGNAL_PARALLEL_HELPERS)
+        parallel_helpers = SIGNAL_PARALLEL_HELPERS;
+
+    const char* interval = getenv("SIGNAL_STATS_INTERVAL");
+    const char* timing = getenv("SIGNAL_STATS");
+    signal_stats_configure(timing && atoi(timing) != 0, interval ? (float)atof(interval) : 0.0f);
+
+    const char* record = getenv("SIGNAL_RECORD");
+    if (record && *record && signal_record_start(record) != 0)
+        CC_LOG_ERROR(ctx, "[signals] could not open trace file %s", record);
 
     CC_BIND(ctx, CC_SIGNAL_CONNECT, signal_connect, sizeof(signal_connect), false);
     CC_BIND(ctx, CC_SIGNAL_EMIT, signal_emit, sizeof(signal_emit), false);
     CC_BIND(ctx, CC_SIGNAL_DEFERRED, signal_emit_deferred, sizeof(signal_emit_deferred), false);
+    CC_BIND(ctx, CC_SIGNAL_DISCONNECT, signal_disconnect, sizeof(signal_disconnect), false);
+    CC_BIND(ctx, CC_SIGNAL_REGISTER, signal_register, sizeof(signal_register), false);
+    CC_BIND(ctx, CC_SIGNAL_CONNECT_ID, signal_connect_id, sizeof(signal_connect_id), false);
+    CC_BIND(ctx, CC_SIGNAL_EMIT_ID, signal_emit_id, sizeof(signal_emit_id), false);
+    CC_BIND(ctx, CC_SIGNAL_DEFERRED_ID, signal_emit_deferred_id, sizeof(signal_emit_deferred_id), false);
+    CC_BIND(ctx, CC_SIGNAL_DEFERRED_COPY, signal_emit_deferred_copy, sizeof(signal_emit_deferred_copy), false);
+    CC_BIND(ctx, CC_SIGNAL_REGISTER_COALESCED, signal_register_coalesced, sizeof(signal_register_coalesced), false);
+    CC_BIND(ctx, CC_SIGNAL_CONNECT_FROM, signal_connect_from, sizeof(signal_connect_from), false);
+    CC_BIND(ctx, CC_SIGNAL_FLUSH, signal_flush, sizeof(signal_flush), false);
+    CC_BIND(ctx, CC_SIGNAL_RECORD_START, signal_record_start, sizeof(signal_record_start), false);
+    CC_BIND(ctx, CC_SIGNAL_RECORD_STOP, signal_record_stop, sizeof(signal_record_stop), false);
+    CC_BIND(ctx, CC_SIGNAL_STATS, signal_stats, sizeof(signal_stats), false);
+    CC_BIND(ctx, CC_SIGNAL_STATS_DUMP, signal_stats_dump, sizeof(signal_stats_dump), false);
+    CC_BIND(ctx, CC_SIGNAL_STATS_CONFIGURE, signal_stats_configure, sizeof(signal_stats_configure), false);
+    CC_BIND(ctx, CC_SIGNAL_STATS_RESET, signal_stats_reset, sizeof(signal_stats_reset), false);
+    CC_BIND(ctx, CC_SIGNAL_CONNECT_PATTERN, signal_connect_pattern, sizeof(signal_connect_pattern), false);
+    CC_BIND(ctx, CC_SIGNAL_CONNECT_EX, signal_connect_ex, sizeof(signal_connect_ex), false);
+    CC_BIND(ctx, CC_SIGNAL_SET_PARALLEL_THRESHOLD, signal_set_parallel_threshold, sizeof(signal_set_parallel_threshold), false);
+    CC_BIND(ctx, CC_SIGNAL_CONNECT_BATCH, signal_connect_batch, sizeof(signal_connect_batch), false);
+    CC_BIND(ctx, CC_SIGNAL_EMIT_BATCH, signal_emit_batch, sizeof(signal_emit_batch), false);
+    CC_BIND(ctx, CC_SIGNAL_EMIT_BATCH_ID, signal_emit_batch_id, sizeof(signal_emit_batch_id), false);
 
     return 0;
 }
 
 int update(CoreContext* ctx) {
     signal_flush(ctx);
+
+    if (stats_interval > 0.0f) {
+        stats_elapsed += ctx->delta_time;
+        if (stats_elapsed >= stats_interval) {
+            stats_elapsed = 0.0f;
+            signal_stats_dump(ctx);
+        }
+    }
     return 0;
 }
 
 int shutdown(CoreContext* ctx) {
     (void)ctx;
-    signal_queue_free(&signal_queue);
+    signal_record_stop();
+    thread_queues_stop();
+    signal_queue_free(&signal_queues[0]);
+    signal_queue_free(&signal_queues[1]);
+    free(flush_scratch.events);
+    free(flush_scratch.groups);
+    memset(&flush_scratch, 0, sizeof(flush_scratch));
+    pattern_table_free();
+    signal_table_free();
+    slot_table_free();
+#ifdef SIGNAL_PROFILE_LISTENERS
+    listener_profiles_free();
+#endif
     mm_free(&signal_map);
     return 0;
 }
 
 static const char* deps[] = { NULL };
-static const char* optional[] = { NULL };
+static const char* optional[] = { "Threads", NULL };
 static PluginMetadata meta = { "Signals", deps, optional };
 
 PluginAPI Load() {
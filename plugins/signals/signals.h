@@ -4,12 +4,22 @@
  *
  * This plugin implements a Godot-style signal system, supporting synchronous and deferred signal emission,
  * allowing decoupled event-driven logic between plugins using `CoreContext`.
+ *
+ * Signals are registered once with `signal_register()` and addressed by an integer `SignalHandle`
+ * afterwards, which indexes the listener table directly. The string-based functions are thin
+ * wrappers that resolve the name on every call.
+ *
+ * Deferred emits may be called from any thread. Calls made off the main thread go through a
+ * lock-free per-thread queue that `signal_flush` drains on the main thread, after the main
+ * thread's own deferred signals and in the order the producing threads first emitted.
+ * Everything else (connect, disconnect, register, immediate emit) is main-thread only.
  */
 
  #ifndef _SIGNALS_H
  #define _SIGNALS_H
  
  #include "../../include/plugin_api.h"
+ #include <stdint.h>
 
 
  
@@ -36,10 +46,214 @@
   *   void (*)(const char* signal_name, void* sender, void* args)
   */
  #define CC_SIGNAL_DEFERRED "signal::emit_deferred"
+
+ /**
+  * Disconnects a connection by the id returned when connecting.
+  *
+  * Signature:
+  *   void (*)(SignalID id)
+  */
+ #define CC_SIGNAL_DISCONNECT "signal::disconnect"
+
+ /**
+  * Registers (or looks up) a signal name and returns its handle.
+  *
+  * Signature:
+  *   SignalHandle (*)(const char* signal_name)
+  */
+ #define CC_SIGNAL_REGISTER "signal::register"
+
+ /**
+  * Connects a callback to a signal handle.
+  *
+  * Signature:
+  *   SignalID (*)(SignalHandle signal, SignalCallback cb, void* user_data)
+  */
+ #define CC_SIGNAL_CONNECT_ID "signal::connect_id"
+
+ /**
+  * Emits a signal handle immediately (synchronous).
+  *
+  * Signature:
+  *   void (*)(CoreContext* ctx, SignalHandle signal, void* sender, void* args)
+  */
+ #define CC_SIGNAL_EMIT_ID "signal::emit_id"
+
+ /**
+  * Emits a signal handle at the end of the current frame (deferred).
+  *
+  * Signature:
+  *   void (*)(SignalHandle signal, void* sender, void* args)
+  */
+ #define CC_SIGNAL_DEFERRED_ID "signal::emit_deferred_id"
+
+ /**
+  * Emits a signal handle at the end of the current frame, copying the payload into a
+  * per-frame arena owned by the Signals plugin.
+  *
+  * Signature:
+  *   void (*)(SignalHandle signal, void* sender, const void* payload, size_t size)
+  */
+ #define CC_SIGNAL_DEFERRED_COPY "signal::emit_deferred_copy"
+
+ /**
+  * Connects a batch listener to a named signal.
+  *
+  * Signature:
+  *   SignalID (*)(const char* signal_name, SignalBatchCallback cb, void* user_data)
+  */
+ #define CC_SIGNAL_CONNECT_BATCH "signal::connect_batch"
+
+ /**
+  * Emits a signal once for every element of an argument array (synchronous).
+  *
+  * Signature:
+  *   void (*)(CoreContext* ctx, const char* signal_name, void* sender, void* args_array, size_t count, size_t stride)
+  */
+ #define CC_SIGNAL_EMIT_BATCH "signal::emit_batch"
+
+ /**
+  * Handle-based variant of CC_SIGNAL_EMIT_BATCH.
+  *
+  * Signature:
+  *   void (*)(CoreContext* ctx, SignalHandle signal, void* sender, void* args_array, size_t count, size_t stride)
+  */
+ #define CC_SIGNAL_EMIT_BATCH_ID "signal::emit_batch_id"
+
+ /**
+  * Registers a signal with a coalescing policy for its deferred emissions.
+  *
+  * Signature:
+  *   SignalHandle (*)(const char* signal_name, SignalCoalesce policy)
+  */
+ #define CC_SIGNAL_REGISTER_COALESCED "signal::register_coalesced"
+
+ /**
+  * Connects a callback that only runs for emissions from one sender.
+  *
+  * Signature:
+  *   SignalID (*)(const char* signal_name, void* sender, SignalCallback cb, void* user_data)
+  */
+ #define CC_SIGNAL_CONNECT_FROM "signal::connect_from"
+
+ /**
+  * Connects a listener described by a SignalConnectDesc.
+  *
+  * Signature:
+  *   SignalID (*)(const SignalConnectDesc* desc)
+  */
+ #define CC_SIGNAL_CONNECT_EX "signal::connect_ex"
+
+ /**
+  * Connects a callback to every signal whose name matches a pattern.
+  *
+  * Signature:
+  *   SignalID (*)(const char* pattern, SignalCallback cb, void* user_data)
+  */
+ #define CC_SIGNAL_CONNECT_PATTERN "signal::connect_pattern"
+
+ /**
+  * Returns the profiling counters of a signal (NULL for unknown handles).
+  *
+  * Signature:
+  *   const SignalStats* (*)(SignalHandle signal)
+  */
+ #define CC_SIGNAL_STATS "signal::stats"
+
+ /**
+  * Logs the counters of every signal that has been emitted, slowest first.
+  *
+  * Signature:
+  *   void (*)(CoreContext* ctx)
+  */
+ #define CC_SIGNAL_STATS_DUMP "signal::stats_dump"
+
+ /**
+  * Turns listener timing on or off and sets the periodic dump interval (0 = never).
+  *
+  * Signature:
+  *   void (*)(int timing, float dump_interval)
+  */
+ #define CC_SIGNAL_STATS_CONFIGURE "signal::stats_configure"
+
+ /**
+  * Clears the counters of every signal.
+  *
+  * Signature:
+  *   void (*)(void)
+  */
+ #define CC_SIGNAL_STATS_RESET "signal::stats_reset"
+
+ /**
+  * Delivers the deferred signals queued so far (normally done by the plugin's update).
+  * Main thread only, and not from a listener: such calls are ignored and the signals wait for
+  * the next flush.
+  *
+  * Signature:
+  *   void (*)(CoreContext* ctx)
+  */
+ #define CC_SIGNAL_FLUSH "signal::flush"
+
+ /**
+  * Starts recording signal traffic to a trace file.
+  *
+  * Signature:
+  *   int (*)(const char* path)
+  */
+ #define CC_SIGNAL_RECORD_START "signal::record_start"
+
+ /**
+  * Stops recording and closes the trace file.
+  *
+  * Signature:
+  *   void (*)(void)
+  */
+ #define CC_SIGNAL_RECORD_STOP "signal::record_stop"
+
+ /**
+  * Sets how many thread-safe listeners a connection list needs before they are fanned out
+  * to the Threads plugin (0 disables parallel dispatch).
+  *
+  * Signature:
+  *   void (*)(size_t threshold)
+  */
+ #define CC_SIGNAL_SET_PARALLEL_THRESHOLD "signal::set_parallel_threshold"
+
+ /**
+  * @def SIGNAL_PARALLEL_THRESHOLD
+  * @brief Default number of thread-safe listeners on one list before emits fan them out.
+  *
+  * Fanning out to the pool costs a few microseconds per emit (`build/bench_signals parallel`),
+  * so 64 listeners come out ahead once they average more than about 100 ns each.
+  */
+ #ifndef SIGNAL_PARALLEL_THRESHOLD
+ #define SIGNAL_PARALLEL_THRESHOLD 64
+ #endif
  
  typedef uint64_t SignalID;
 
  #define SIGNAL_INVALID_ID 0
+
+ /**
+  * @brief Set in the SignalIDs returned for pattern subscriptions.
+  */
+ #define SIGNAL_PATTERN_ID_BIT (1ull << 63)
+
+ /**
+  * @brief Integer handle of a registered signal; indexes the signal table directly.
+  */
+ typedef uint32_t SignalHandle;
+
+ #define SIGNAL_INVALID_HANDLE 0
+
+ /**
+  * @brief What happens when a signal is deferred several times by the same sender in one frame.
+  */
+ typedef enum {
+     SIGNAL_COALESCE_ALL = 0,        /**< Deliver every emission (default). */
+     SIGNAL_COALESCE_LATEST,         /**< Deliver only the last emission per sender, at the position of the first. */
+     SIGNAL_COALESCE_FIRST,          /**< Deliver only the first emission per sender. */
+ } SignalCoalesce;
  
  /**
   * @brief Function pointer type for signal callbacks.
@@ -50,6 +264,24 @@
   * @param user_data  Custom user data provided during connection.
   */
  typedef void (*SignalCallback)(CoreContext* ctx, void* sender, void* args, void* user_data);
+
+ /**
+  * @brief One emission of a signal, as delivered to batch listeners.
+  */
+ typedef struct {
+     void* sender;                   /**< The originator of the signal. */
+     void* args;                     /**< Argument payload of this emission. */
+ } SignalEvent;
+
+ /**
+  * @brief Function pointer type for batch listeners, which receive a span of emissions in one call.
+  *
+  * @param ctx        Pointer to the CoreContext of the system.
+  * @param events     Emissions in the order they were made; valid only during the call.
+  * @param count      Number of emissions.
+  * @param user_data  Custom user data provided during connection.
+  */
+ typedef void (*SignalBatchCallback)(CoreContext* ctx, const SignalEvent* events, size_t count, void* user_data);
  
 
  /**
@@ -58,37 +290,246 @@
  typedef struct {
      SignalID id;                    /**< Unique identifier. */
      const char* signal_name;        /**< The name of the signal to listen to. */
-     SignalCallback callback;        /**< The callback function to invoke when the signal is emitted. */
+     SignalCallback callback;        /**< The callback function to invoke when the signal is emitted. NULL once disconnected. */
+     SignalBatchCallback batch_callback; /**< Set instead of `callback` for batch listeners. NULL once disconnected. */
      void* user_data;                /**< Optional user data to pass to the callback. */
+     uint32_t flags;                 /**< SignalConnectFlags. */
  } SignalConnection;
  
+ /**
+  * @brief Options of a connection.
+  */
+ typedef enum {
+     SIGNAL_CONNECT_THREAD_SAFE = 1 << 0,    /**< The listener may run on a worker thread, concurrently with other thread-safe listeners. */
+     SIGNAL_CONNECT_FROM_SENDER = 1 << 1,    /**< Only invoke the listener for emissions from SignalConnectDesc::sender. */
+ } SignalConnectFlags;
+
+ /**
+  * @brief Describes a connection for signal_connect_ex().
+  */
+ typedef struct {
+     const char* signal;             /**< Signal name, used when `handle` is SIGNAL_INVALID_HANDLE. */
+     SignalHandle handle;            /**< Signal handle. */
+     SignalCallback callback;        /**< Per-emission listener; exactly one of the callbacks must be set. */
+     SignalBatchCallback batch_callback; /**< Batch listener. */
+     void* user_data;                /**< Passed to the listener. */
+     void* sender;                   /**< Sender to filter on with SIGNAL_CONNECT_FROM_SENDER. */
+     uint32_t flags;                 /**< SignalConnectFlags. */
+ } SignalConnectDesc;
+
  /**
   * @brief A dynamically resizable list of signal connections.
+  *
+  * Disconnected entries are left as tombstones (NULL callbacks) and compacted away once they
+  * make up half the array and no emit of the signal is in progress.
   */
  typedef struct {
      SignalConnection* data;         /**< Array of signal connections. */
-     size_t count;                   /**< Number of active connections. */
+     size_t count;                   /**< Number of used entries, tombstones included. */
      size_t capacity;                /**< Allocated size of the connection array. */
+     size_t tombstones;              /**< Number of disconnected entries awaiting compaction. */
+     size_t thread_safe;             /**< Number of live SIGNAL_CONNECT_THREAD_SAFE entries. */
  } SignalConnectionArray;
  
+ /**
+  * @brief Listeners of a signal that only want emissions from one sender.
+  */
+ typedef struct {
+     void* sender;                   /**< Sender the listeners are filtered on. */
+     SignalConnectionArray listeners;/**< Connected callbacks, in connection order. */
+ } SignalSenderListeners;
+
+ /**
+  * @brief Open-addressing map entry from a sender to its SignalSenderListeners.
+  */
+ typedef struct {
+     void* sender;                   /**< Key. */
+     uint32_t list;                  /**< 1-based index into SignalSenderIndex::lists, 0 = empty bucket. */
+ } SignalSenderIndexEntry;
+
+ /**
+  * @brief Per-signal index of sender-filtered listeners, so an emit only visits the lists of its sender.
+  *
+  * Lists are stored densely and addressed by 1-based index (0 is the signal's wildcard list).
+  * Lists left empty by disconnects are removed once no emit of the signal is in progress.
+  */
+ typedef struct {
+     SignalSenderListeners* lists;   /**< Dense array of per-sender lists. */
+     uint32_t count;                 /**< Number of lists. */
+     uint32_t capacity;              /**< Allocated size of `lists`. */
+     SignalSenderIndexEntry* map;    /**< Sender -> list, power of two sized. */
+     size_t map_capacity;            /**< Allocated size of `map`. */
+     int dirty;                      /**< A list has tombstones awaiting compaction. */
+ } SignalSenderIndex;
+
+ /**
+  * @brief Profiling counters of a signal.
+  *
+  * Counters are always kept; the times are only measured while timing is enabled
+  * (CC_SIGNAL_STATS_CONFIGURE, or `SIGNAL_STATS=1` / `SIGNAL_STATS_INTERVAL=<seconds>` in the
+  * environment). Times include nested emits made by listeners.
+  */
+ typedef struct {
+     uint64_t emits;                 /**< Emissions delivered, immediate and deferred. */
+     uint64_t deferred;              /**< Deferred emissions queued. */
+     uint64_t coalesced;             /**< Deferred emissions merged away by the coalescing policy. */
+     uint64_t dispatches;            /**< Listener passes (one per immediate emit, batch, or flush group). */
+     uint64_t listener_calls;        /**< Listener invocations. */
+     uint32_t last_fan_out;          /**< Listeners run by the last dispatch. */
+     uint32_t max_fan_out;           /**< Most listeners run by one dispatch. */
+     uint32_t last_flush_depth;      /**< Emissions of this signal delivered by the last flush that had any. */
+     uint32_t max_flush_depth;       /**< Most emissions of this signal delivered by one flush. */
+     uint64_t total_ns;              /**< Time spent in listeners. */
+     uint64_t worst_ns;              /**< Longest single dispatch. */
+ } SignalStats;
+
+ /**
+  * @brief A registered signal and its listeners.
+  */
+ typedef struct {
+     char* name;                     /**< Owned copy of the signal name. */
+     SignalConnectionArray listeners;/**< Connected callbacks, in connection order. */
+     SignalSenderIndex senders;      /**< Sender-filtered callbacks. */
+     uint32_t emitting;              /**< Nesting depth of emits in progress; structural changes are deferred while non-zero. */
+     SignalCoalesce coalesce;        /**< Policy applied when the signal is deferred. */
+     SignalStats stats;              /**< Profiling counters. */
+     size_t flush_count;             /**< Queued signals of this entry counted by the current flush. */
+     size_t flush_offset;            /**< Start of this entry's batch in the flush's event array. */
+ } SignalEntry;
+
+ /**
+  * @brief Locates a connection from its SignalID so that disconnecting is O(1).
+  *
+  * A SignalID packs the slot index (low 32 bits) with the slot generation (high 32 bits),
+  * so stale ids are rejected after the slot is reused.
+  */
+ typedef struct {
+     SignalHandle signal;            /**< Signal the connection belongs to. */
+     uint32_t list;                  /**< 0 for the wildcard list, otherwise the 1-based sender list. */
+     uint32_t index;                 /**< Position in that connection array. */
+     uint32_t generation;            /**< Bumped every time the slot is released. */
+     uint32_t next_free;             /**< Next free slot while the slot is unused. */
+ } SignalSlot;
+
+ /**
+  * @brief A pattern subscription and the connections it made on matching signals.
+  */
+ typedef struct {
+     char* pattern;                  /**< Owned copy of the pattern, NULL while the slot is free. */
+     SignalConnectDesc desc;         /**< Connection made on every matching signal (`signal`/`handle` unused). */
+     SignalID* attached;             /**< Connections made so far. */
+     size_t attached_count;          /**< Number of attached connections. */
+     size_t attached_capacity;       /**< Allocated size of `attached`. */
+     uint32_t generation;            /**< Bumped when the slot is released, stale ids are ignored. */
+     uint32_t next_free;             /**< Next free pattern slot while unused. */
+     uint32_t match_stamp;           /**< Last match pass that collected the pattern (deduplicates `**`). */
+ } SignalPattern;
+
+ /**
+  * @brief One `::`-separated segment of the pattern trie.
+  *
+  * A segment is a literal name, `*` (exactly one segment) or `**` (any number of segments,
+  * including none).
+  */
+ typedef struct SignalPatternNode {
+     char* segment;                  /**< Owned segment text, NULL for the root. */
+     struct SignalPatternNode* children; /**< Child segments. */
+     uint32_t child_count;           /**< Number of children. */
+     uint32_t child_capacity;        /**< Allocated size of `children`. */
+     uint32_t* patterns;             /**< Patterns ending at this node. */
+     uint32_t pattern_count;         /**< Number of patterns. */
+     uint32_t pattern_capacity;      /**< Allocated size of `patterns`. */
+ } SignalPatternNode;
+
  /**
   * @brief Represents a queued (deferred) signal.
   */
  typedef struct {
-     const char* name;               /**< Signal name. */
+     SignalHandle signal;            /**< Signal handle. */
      void* sender;                   /**< The originator of the signal. */
-     void* args;                     /**< Optional argument payload. */
+     void* args;                     /**< Optional argument payload (unused when payload_size is non-zero). */
+     size_t payload_offset;          /**< Offset of the copied payload in the queue's arena. */
+     size_t payload_size;            /**< Size of the copied payload, 0 if `args` is passed through. */
  } QueuedSignal;
  
+ /**
+  * @brief Maps a (signal, sender) pair to its queue position for coalesced signals.
+  *
+  * Entries are only valid while `stamp` matches the owning queue's, so the table is
+  * emptied each frame by bumping the queue's stamp instead of clearing it.
+  */
+ typedef struct {
+     SignalHandle signal;            /**< Signal of the queued entry. */
+     uint32_t stamp;                 /**< Frame stamp the entry was written in. */
+     void* sender;                   /**< Sender of the queued entry. */
+     size_t index;                   /**< Position of the entry in the queue. */
+ } SignalCoalesceEntry;
+
  /**
   * @brief A dynamically resizable queue of deferred signals.
+  *
+  * Copied payloads live in the queue's arena and are addressed by offset, so the arena can
+  * grow while signals are queued. The arena is reset when the queue is flushed.
   */
  typedef struct {
      QueuedSignal* data;             /**< Array of queued signals. */
      size_t count;                   /**< Number of queued signals. */
      size_t capacity;                /**< Allocated size of the queue. */
+     unsigned char* arena;           /**< Per-frame payload storage. */
+     size_t arena_used;              /**< Bytes of the arena in use. */
+     size_t arena_capacity;          /**< Allocated size of the arena. */
+     SignalCoalesceEntry* coalesce;  /**< Open-addressing (signal, sender) table, power of two sized. */
+     size_t coalesce_count;          /**< Entries written this frame. */
+     size_t coalesce_capacity;       /**< Allocated size of the table. */
+     uint32_t coalesce_stamp;        /**< Current frame stamp, never 0. */
  } SignalQueueArray;
  
+ // ---------------- Trace format ----------------
+
+ #define SIGNAL_TRACE_MAGIC   0x43525453u /* "STRC" */
+ #define SIGNAL_TRACE_VERSION 1
+
+ /**
+  * @brief Kinds of records stored in a signal trace.
+  */
+ typedef enum {
+     ST_NAME = 1,                    /**< Defines trace signal id `signal`; payload is the name. */
+     ST_EMIT,                        /**< Immediate emit (`count` > 1 for a batch). */
+     ST_DEFERRED,                    /**< Deferred emit. */
+ } SignalTraceKind;
+
+ /**
+  * @brief Flags of a trace record.
+  */
+ typedef enum {
+     ST_PAYLOAD = 1 << 0,            /**< The payload holds the argument bytes (`count` elements of `stride` bytes). */
+     ST_ARGS_DROPPED = 1 << 1,       /**< Non-NULL args of unknown size were passed and not recorded. */
+ } SignalTraceFlags;
+
+ /**
+  * @brief Written once at the start of every trace file.
+  */
+ typedef struct {
+     uint32_t magic;                 /**< SIGNAL_TRACE_MAGIC. */
+     uint16_t version;               /**< SIGNAL_TRACE_VERSION. */
+     uint16_t record_header_size;    /**< sizeof(SignalTraceRecord) of the writer. */
+ } SignalTraceFileHeader;
+
+ /**
+  * @brief Fixed-size header preceding every record payload.
+  */
+ typedef struct {
+     uint8_t kind;                   /**< SignalTraceKind. */
+     uint8_t flags;                  /**< SignalTraceFlags. */
+     uint16_t reserved;
+     uint32_t signal;                /**< Trace signal id, defined by an earlier ST_NAME record. */
+     uint32_t frame;                 /**< Frame (Signals update) the emit was made in. */
+     uint32_t size;                  /**< Payload size in bytes. */
+     uint32_t count;                 /**< Number of emissions (batches). */
+     uint32_t stride;                /**< Bytes per emission in the payload. */
+     uint64_t sender;                /**< Sender pointer value; opaque to a replay. */
+ } SignalTraceRecord;
+
  /**
   * @brief Connects a callback to a named signal.
   *
@@ -100,6 +541,135 @@
  
  typedef SignalID (*signal_connect_fn_t)(const char* name, SignalCallback cb, void* user_data);
 
+ /**
+  * @brief Connects a callback that is only invoked for emissions whose sender is `sender`.
+  *
+  * Emitting costs one hash lookup for the sender plus its own listeners, regardless of how
+  * many other senders have listeners. Wildcard listeners run before sender listeners.
+  *
+  * @param name       The name of the signal to listen for.
+  * @param sender     Sender to filter on (NULL filters on emissions with a NULL sender).
+  * @param cb         The callback function to invoke.
+  * @param user_data  Optional user data to be passed to the callback.
+  */
+ SignalID signal_connect_from(const char* name, void* sender, SignalCallback cb, void* user_data);
+
+ typedef SignalID (*signal_connect_from_fn_t)(const char* name, void* sender, SignalCallback cb, void* user_data);
+
+ /**
+  * @brief Handle-based variant of signal_connect_from().
+  */
+ SignalID signal_connect_from_id(SignalHandle signal, void* sender, SignalCallback cb, void* user_data);
+
+ typedef SignalID (*signal_connect_from_id_fn_t)(SignalHandle signal, void* sender, SignalCallback cb, void* user_data);
+
+ /**
+  * @brief Connects a listener with options, e.g. a thread-safe or sender-filtered batch listener.
+  *
+  * When a connection list holds at least the parallel threshold of thread-safe listeners and the
+  * Threads plugin is loaded, emits split those listeners across `thread::spawn` jobs. The emitting
+  * thread runs the remaining listeners in order, helps with the thread-safe ones and returns once
+  * all of them have finished. Thread-safe listeners must not connect, disconnect or emit
+  * immediately; they may defer signals. They see the connections as of the start of the emit.
+  *
+  * @return The connection id, or SIGNAL_INVALID_ID if the description is invalid.
+  */
+ SignalID signal_connect_ex(const SignalConnectDesc* desc);
+
+ typedef SignalID (*signal_connect_ex_fn_t)(const SignalConnectDesc* desc);
+
+ /**
+  * @brief Sets the parallel dispatch threshold (see CC_SIGNAL_SET_PARALLEL_THRESHOLD).
+  */
+ void signal_set_parallel_threshold(size_t threshold);
+
+ typedef void (*signal_set_parallel_threshold_fn_t)(size_t threshold);
+
+ /**
+  * @brief Connects a callback to every signal whose name matches `pattern`, now or when registered later.
+  *
+  * Patterns are `::`-separated like signal names: `*` matches exactly one segment and `**` any
+  * number of segments, e.g. `graphics::*`, `*::damaged` or `ui::**`. Patterns are kept in a
+  * segment trie that is matched once per signal at registration, and every match gets an
+  * ordinary connection, so emitting costs the same as for exact-name listeners.
+  * This is the only way to subscribe by pattern: names given to signal_connect() and the other
+  * connect functions are always literal, `*` included.
+  *
+  * A `*` must make up a whole segment: partial wildcards such as `ui::on_*` or `foo*bar` are
+  * rejected rather than matched literally.
+  *
+  * @return An id with SIGNAL_PATTERN_ID_BIT set; disconnecting it removes every connection it made,
+  *         or SIGNAL_INVALID_ID for an invalid pattern.
+  */
+ SignalID signal_connect_pattern(const char* pattern, SignalCallback cb, void* user_data);
+
+ typedef SignalID (*signal_connect_pattern_fn_t)(const char* pattern, SignalCallback cb, void* user_data);
+
+ /**
+  * @brief Returns the profiling counters of a signal, or NULL for an unknown handle.
+  *
+  * The pointer is invalidated when a signal is registered.
+  */
+ const SignalStats* signal_stats(SignalHandle signal);
+
+ typedef const SignalStats* (*signal_stats_fn_t)(SignalHandle signal);
+
+ /**
+  * @brief Logs the counters of every emitted signal at info level, slowest (or busiest) first.
+  *
+  * Built with `-DSIGNAL_PROFILE_LISTENERS` the dump also names the slowest listener of each signal.
+  */
+ void signal_stats_dump(CoreContext* ctx);
+
+ typedef void (*signal_stats_dump_fn_t)(CoreContext* ctx);
+
+ /**
+  * @brief Enables listener timing and the periodic dump.
+  *
+  * @param timing         Non-zero to measure listener time (two clock reads per dispatch).
+  * @param dump_interval  Seconds between dumps from the plugin's update, 0 to disable; implies timing.
+  */
+ void signal_stats_configure(int timing, float dump_interval);
+
+ typedef void (*signal_stats_configure_fn_t)(int timing, float dump_interval);
+
+ /**
+  * @brief Clears the counters of every signal (and of every listener).
+  */
+ void signal_stats_reset(void);
+
+ typedef void (*signal_stats_reset_fn_t)(void);
+
+ /**
+  * @brief Delivers the deferred signals queued so far and advances the frame counter.
+  *
+  * Must be called on the main thread outside of signal dispatch; a flush from a listener or
+  * from another thread is ignored.
+  */
+ void signal_flush(CoreContext* ctx);
+
+ typedef void (*signal_flush_fn_t)(CoreContext* ctx);
+
+ /**
+  * @brief Starts writing every top-level emit to a trace file (see SignalTraceRecord).
+  *
+  * Emits made by listeners are not recorded since a replay reproduces them by running the
+  * listeners. Payloads are recorded where their size is known: signal_emit_deferred_copy()
+  * and batches with a stride. `SIGNAL_RECORD=<path>` in the environment starts recording at init.
+  *
+  * @return 0 on success, non-zero if the file could not be opened.
+  */
+ int signal_record_start(const char* path);
+
+ typedef int (*signal_record_start_fn_t)(const char* path);
+
+ /**
+  * @brief Stops recording and closes the trace file.
+  */
+ void signal_record_stop(void);
+
+ typedef void (*signal_record_stop_fn_t)(void);
+
  /**
   * @brief Emits a signal immediately (synchronously).
   *
@@ -115,6 +685,12 @@
  /**
   * @brief Queues a signal to be emitted on the next frame.
   *
+  * Signals deferred by a listener while the queue is being flushed are delivered by the
+  * following flush. The flush groups queued signals by signal: each signal's listeners run
+  * once over all of its emissions of the frame (in emission order), with signals taken in
+  * the order they were first deferred. `args` is passed through as-is and must outlive the flush; use
+  * signal_emit_deferred_copy() to hand over a payload by value instead.
+  *
   * @param name    The signal name to emit.
   * @param sender  The signal emitter.
   * @param args    Optional argument payload.
@@ -123,10 +699,127 @@
 
  typedef void (*signal_emit_deferred_fn_t)(const char* name, void* sender, void* args);
 
+ /**
+  * @brief Disconnects a connection in O(1).
+  *
+  * Safe to call from inside a listener, including for the connection currently being
+  * invoked. Connections added during an emit are not invoked by that emit.
+  *
+  * @param id  The id returned when connecting. Stale or unknown ids are ignored.
+  */
  void signal_disconnect(SignalID id);
 
  typedef void (*signal_disconnect_fn_t)(SignalID id);
 
+ /**
+  * @brief Registers a signal name, or returns the existing handle if it is already registered.
+  *
+  * Resolving the name once and using the handle afterwards skips the string hash on every emit.
+  *
+  * @param name  The signal name.
+  * @return The signal handle, or SIGNAL_INVALID_HANDLE on failure.
+  */
+ SignalHandle signal_register(const char* name);
+
+ typedef SignalHandle (*signal_register_fn_t)(const char* name);
+
+ /**
+  * @brief Registers a signal and sets the coalescing policy of its deferred emissions.
+  *
+  * Coalescing is keyed on (signal, sender) and reset every frame. It applies to every deferred
+  * emit, including those made from other threads; immediate emits are never coalesced.
+  * Calling it on an existing signal replaces the policy.
+  */
+ SignalHandle signal_register_coalesced(const char* name, SignalCoalesce policy);
+
+ typedef SignalHandle (*signal_register_coalesced_fn_t)(const char* name, SignalCoalesce policy);
+
+ /**
+  * @brief Connects a callback to a signal handle.
+  */
+ SignalID signal_connect_id(SignalHandle signal, SignalCallback cb, void* user_data);
+
+ typedef SignalID (*signal_connect_id_fn_t)(SignalHandle signal, SignalCallback cb, void* user_data);
+
+ /**
+  * @brief Emits a signal handle immediately (synchronously).
+  */
+ void signal_emit_id(CoreContext* ctx, SignalHandle signal, void* sender, void* args);
+
+ typedef void (*signal_emit_id_fn_t)(CoreContext* ctx, SignalHandle signal, void* sender, void* args);
+
+ /**
+  * @brief Queues a signal handle to be emitted on the next frame.
+  */
+ void signal_emit_deferred_id(SignalHandle signal, void* sender, void* args);
+
+ typedef void (*signal_emit_deferred_id_fn_t)(SignalHandle signal, void* sender, void* args);
+
+ /**
+  * @brief Queues a signal with a copy of its payload to be emitted on the next frame.
+  *
+  * The payload is copied into the Signals plugin's per-frame arena, so the caller does not
+  * need to keep it alive. Listeners receive a pointer into the arena (aligned for any type)
+  * that stays valid until the flush delivering it returns.
+  *
+  * @param signal   The signal handle.
+  * @param sender   The signal emitter.
+  * @param payload  Bytes to copy; may be NULL only when `size` is 0.
+  * @param size     Payload size in bytes.
+  */
+ void signal_emit_deferred_copy(SignalHandle signal, void* sender, const void* payload, size_t size);
+
+ typedef void (*signal_emit_deferred_copy_fn_t)(SignalHandle signal, void* sender, const void* payload, size_t size);
+
+ /**
+  * @brief Connects a batch listener to a named signal.
+  *
+  * A batch listener is called once per emit with every emission made by it: once for
+  * signal_emit_batch(), and once per frame for all deferred emissions of the signal.
+  * Plain listeners of a batch are called once per element instead.
+  */
+ SignalID signal_connect_batch(const char* name, SignalBatchCallback cb, void* user_data);
+
+ typedef SignalID (*signal_connect_batch_fn_t)(const char* name, SignalBatchCallback cb, void* user_data);
+
+ /**
+  * @brief Connects a batch listener to a signal handle.
+  */
+ SignalID signal_connect_batch_id(SignalHandle signal, SignalBatchCallback cb, void* user_data);
+
+ typedef SignalID (*signal_connect_batch_id_fn_t)(SignalHandle signal, SignalBatchCallback cb, void* user_data);
+
+ /**
+  * @brief Emits a signal once per array element in a single pass (synchronous).
+  *
+  * Each listener runs to completion over the whole batch before the next listener is called.
+  *
+  * @param ctx         The CoreContext in which to emit the signal.
+  * @param name        The signal name to emit.
+  * @param sender      The signal emitter, shared by every element.
+  * @param args_array  First element; element `i` is passed as `args_array + i * stride`.
+  * @param count       Number of elements.
+  * @param stride      Distance between elements in bytes (0 passes `args_array` every time).
+  */
+ void signal_emit_batch(CoreContext* ctx, const char* name, void* sender, void* args_array, size_t count, size_t stride);
+
+ typedef void (*signal_emit_batch_fn_t)(CoreContext* ctx, const char* name, void* sender, void* args_array, size_t count, size_t stride);
+
+ /**
+  * @brief Handle-based variant of signal_emit_batch().
+  */
+ void signal_emit_batch_id(CoreContext* ctx, SignalHandle signal, void* sender, void* args_array, size_t count, size_t stride);
+
+ typedef void (*signal_emit_batch_id_fn_t)(CoreContext* ctx, SignalHandle signal, void* sender, void* args_array, size_t count, size_t stride);
+
+ /**
+  * @def SIGNAL_EMIT_DEFERRED_VALUE
+  * @brief Queues a copy of an lvalue as the payload, e.g.
+  *        `SIGNAL_EMIT_DEFERRED_VALUE(emit_copy_fn, damaged, self, hit_info)`.
+  */
+ #define SIGNAL_EMIT_DEFERRED_VALUE(fn, signal, sender, value) \
+     (fn)((signal), (sender), &(value), sizeof(value))
+
  
  #endif /* _SIGNALS_H */
  
\ No newline at end of file
@@ -2,6 +2,14 @@
 #include <stdlib.h>
 #include <string.h>
 #include <stdio.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdatomic.h>
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <unistd.h>
+#endif
 
 int core_thrd_create(thrd_t *thr, thrd_start_t func, void *arg)
 {
@@ -33,165 +41,1174 @@ void core_thrd_yield(void)
     thrd_yield();
 }
 
-#define MAX_THREADS 32
-#define MAX_QUEUED_JOBS 64
+#define MAX_WORKERS 64
+#define MAX_JOBS 65536      // job slab size, also bounds the injection queue
+#define MAX_LINKS 65536     // dependency edges in flight
+#define DEQUE_CAPACITY 4096 // per-worker deque, overflow goes to the injection queue
+#define JOB_NONE UINT32_MAX
+#define LINK_NONE UINT32_MAX
+#define CACHE_LINE 64
 
 typedef struct
 {
-    thrd_t handle;
-    int active;
-    int finished;
-    void *user_data;
     int (*fn)(void *);
-} ThreadJob;
+    void *user_data;
+    _Atomic int result;
+    _Atomic uint32_t generation; // odd while the job is live, even once it has finished
+    _Atomic uint32_t pending;    // unfinished dependencies, plus one while it is being spawned
+    uint32_t continuations;      // JobLink list of dependents, guarded by `lock`
+    atomic_flag lock;
+} Job;
 
+/* Edge from a job to one dependent waiting on it. */
 typedef struct
 {
-    int (*fn)(void *);
-    void *user_data;
-} QueuedJob;
+    uint32_t job;
+    uint32_t next;
+} JobLink;
 
+/*
+ * Bounded lock-free MPMC queue of job indices (Vyukov). Each cell's sequence number tells
+ * producers and consumers whose turn it is, so a push or pop is one CAS on the shared index.
+ * Every queue is sized to the slab it indexes, so none can really fill up; a push only sees a
+ * "full" cell while the consumer that emptied it is between its CAS and its release store.
+ */
 typedef struct
 {
-    QueuedJob *data;
-    size_t head;
-    size_t tail;
-    size_t count;
-    size_t capacity;
-} JobQueue;
+    _Atomic size_t seq;
+    uint32_t value;
+} MpmcCell;
+
+typedef struct
+{
+    MpmcCell *cells;
+    size_t mask;
+    _Alignas(CACHE_LINE) _Atomic size_t enqueue_pos;
+    _Alignas(CACHE_LINE) _Atomic size_t dequeue_pos;
+} MpmcQueue;
 
-static JobQueue job_queue;
+/*
+ * Chase-Lev deque (the weak-memory version from Le et al.). The owning worker pushes and
+ * pops at `bottom` without atomic RMWs, thieves take from `top` with a CAS.
+ */
+typedef struct
+{
+    _Alignas(CACHE_LINE) _Atomic int64_t top;
+    _Alignas(CACHE_LINE) _Atomic int64_t bottom;
+    _Alignas(CACHE_LINE) _Atomic uint32_t slots[DEQUE_CAPACITY];
+} WorkDeque;
+
+typedef struct
+{
+    WorkDeque deque;
+    thrd_t handle;
+} Worker;
 
-static ThreadJob jobs[MAX_THREADS];
+static struct
+{
+    Worker workers[MAX_WORKERS];
+    int worker_count; // threads started
+    int deque_count;  // deques scanned by thieves, fixed before the first worker starts
+    Job *jobs;
+    JobLink *links;
+    MpmcQueue free_jobs; // FIFO of free slab indices, so a finished slot is reused as late as possible
+    MpmcQueue free_links;
+    MpmcQueue injection; // jobs submitted from outside the pool
+    _Atomic int sleepers;
+    _Atomic bool quit;
+    mtx_t lock; // guards `wake_epoch` for sleeping workers
+    cnd_t wake;
+    uint64_t wake_epoch;
+} pool;
 
-static int thread_entry(void *arg)
+/* Index of the pool worker running on this thread, -1 everywhere else. */
+static _Thread_local int worker_index = -1;
+static _Thread_local uint32_t steal_rng = 0;
+
+static bool mpmc_init(MpmcQueue *q, size_t capacity)
 {
-    ThreadJob *job = (ThreadJob *)arg;
-    job->fn(job->user_data);
-    job->finished = 1;
-    return 0;
+    q->cells = malloc(sizeof(MpmcCell) * capacity);
+    if (!q->cells)
+        return false;
+    q->mask = capacity - 1;
+    for (size_t i = 0; i < capacity; i++)
+        atomic_store_explicit(&q->cells[i].seq, i, memory_order_relaxed);
+    atomic_store_explicit(&q->enqueue_pos, 0, memory_order_relaxed);
+    atomic_store_explicit(&q->dequeue_pos, 0, memory_order_relaxed);
+    return true;
+}
+
+static void mpmc_free(MpmcQueue *q)
+{
+    free(q->cells);
+    q->cells = NULL;
+}
+
+static void mpmc_push(MpmcQueue *q, uint32_t value)
+{
+    size_t pos = atomic_load_explicit(&q->enqueue_pos, memory_order_relaxed);
+    MpmcCell *cell;
+    for (;;)
+    {
+        cell = &q->cells[pos & q->mask];
+        size_t seq = atomic_load_explicit(&cell->seq, memory_order_acquire);
+        intptr_t diff = (intptr_t)seq - (intptr_t)pos;
+        if (diff == 0)
+        {
+            if (atomic_compare_exchange_weak_explicit(&q->enqueue_pos, &pos, pos + 1,
+                                                      memory_order_relaxed, memory_order_relaxed))
+                break;
+        }
+        else if (diff < 0)
+        {
+            // A preempted consumer still owns the cell, wait for it to publish
+            thrd_yield();
+            pos = atomic_load_explicit(&q->enqueue_pos, memory_order_relaxed);
+        }
+        else
+            pos = atomic_load_explicit(&q->enqueue_pos, memory_order_relaxed);
+    }
+    cell->value = value;
+    atomic_store_explicit(&cell->seq, pos + 1, memory_order_release);
+}
+
+static bool mpmc_pop(MpmcQueue *q, uint32_t *out)
+{
+    size_t pos = atomic_load_explicit(&q->dequeue_pos, memory_order_relaxed);
+    MpmcCell *cell;
+    for (;;)
+    {
+        cell = &q->cells[pos & q->mask];
+        size_t seq = atomic_load_explicit(&cell->seq, memory_order_acquire);
+        intptr_t diff = (intptr_t)seq - (intptr_t)(pos + 1);
+        if (diff == 0)
+        {
+            if (atomic_compare_exchange_weak_explicit(&q->dequeue_pos, &pos, pos + 1,
+                                                      memory_order_relaxed, memory_order_relaxed))
+                break;
+        }
+        else if (diff < 0)
+            return false; // empty
+        else
+            pos = atomic_load_explicit(&q->dequeue_pos, memory_order_relaxed);
+    }
+    *out = cell->value;
+    atomic_store_explicit(&cell->seq, pos + q->mask + 1, memory_order_release);
+    return true;
+}
+
+static bool mpmc_empty(MpmcQueue *q)
+{
+    return atomic_load_explicit(&q->dequeue_pos, memory_order_seq_cst) >=
+           atomic_load_explicit(&q->enqueue_pos, memory_order_seq_cst);
+}
+
+static bool deque_push(WorkDeque *d, uint32_t job)
+{
+    int64_t b = atomic_load_explicit(&d->bottom, memory_order_relaxed);
+    int64_t t = atomic_load_explicit(&d->top, memory_order_acquire);
+    if (b - t >= DEQUE_CAPACITY)
+        return false;
+    atomic_store_explicit(&d->slots[b & (DEQUE_CAPACITY - 1)], job, memory_order_relaxed);
+    atomic_thread_fence(memory_order_release);
+    atomic_store_explicit(&d->bottom, b + 1, memory_order_relaxed);
+    return true;
+}
+
+static uint32_t deque_pop(WorkDeque *d)
+{
+    int64_t b = atomic_load_explicit(&d->bottom, memory_order_relaxed) - 1;
+    atomic_store_explicit(&d->bottom, b, memory_order_relaxed);
+    atomic_thread_fence(memory_order_seq_cst);
+    int64_t t = atomic_load_explicit(&d->top, memory_order_relaxed);
+    if (t > b)
+    {
+        atomic_store_explicit(&d->bottom, b + 1, memory_order_relaxed);
+        return JOB_NONE;
+    }
+    uint32_t job = atomic_load_explicit(&d->slots[b & (DEQUE_CAPACITY - 1)], memory_order_relaxed);
+    if (t == b)
+    {
+        // Last job, race the thieves for it
+        if (!atomic_compare_exchange_strong_explicit(&d->top, &t, t + 1,
+                                                     memory_order_seq_cst, memory_order_relaxed))
+            job = JOB_NONE;
+        atomic_store_explicit(&d->bottom, b + 1, memory_order_relaxed);
+    }
+    return job;
+}
+
+static uint32_t deque_steal(WorkDeque *d)
+{
+    int64_t t = atomic_load_explicit(&d->top, memory_order_acquire);
+    atomic_thread_fence(memory_order_seq_cst);
+    int64_t b = atomic_load_explicit(&d->bottom, memory_order_acquire);
+    if (t >= b)
+        return JOB_NONE;
+    uint32_t job = atomic_load_explicit(&d->slots[t & (DEQUE_CAPACITY - 1)], memory_order_relaxed);
+    if (!atomic_compare_exchange_strong_explicit(&d->top, &t, t + 1,
+                                                 memory_order_seq_cst, memory_order_relaxed))
+        return JOB_NONE; // lost to the owner or another thief
+    return job;
+}
+
+static bool deque_empty(WorkDeque *d)
+{
+    return atomic_load_explicit(&d->top, memory_order_seq_cst) >=
+           atomic_load_explicit(&d->bottom, memory_order_seq_cst);
+}
+
+static uint32_t steal_any(int self)
+{
+    int n = pool.deque_count;
+    if (!n)
+        return JOB_NONE;
+    if (!steal_rng)
+        steal_rng = (uint32_t)(uintptr_t)&steal_rng | 1u; // distinct per thread
+    steal_rng ^= steal_rng << 13;
+    steal_rng ^= steal_rng >> 17;
+    steal_rng ^= steal_rng << 5;
+    int start = (int)(steal_rng % (uint32_t)n);
+    for (int i = 0; i < n; i++)
+    {
+        int victim = (start + i) % n;
+        if (victim == self)
+            continue;
+        uint32_t job = deque_steal(&pool.workers[victim].deque);
+        if (job != JOB_NONE)
+            return job;
+    }
+    return JOB_NONE;
+}
+
+static bool any_work(void)
+{
+    if (!mpmc_empty(&pool.injection))
+        return true;
+    for (int i = 0; i < pool.deque_count; i++)
+        if (!deque_empty(&pool.workers[i].deque))
+            return true;
+    return false;
+}
+
+static void wake_one(void)
+{
+    // Pairs with the sleeper count in worker_sleep: either the sleeper sees the new job or we see it
+    atomic_thread_fence(memory_order_seq_cst);
+    if (!atomic_load_explicit(&pool.sleepers, memory_order_seq_cst))
+        return;
+    mtx_lock(&pool.lock);
+    pool.wake_epoch++;
+    cnd_signal(&pool.wake);
+    mtx_unlock(&pool.lock);
+}
+
+static void worker_sleep(void)
+{
+    mtx_lock(&pool.lock);
+    atomic_fetch_add_explicit(&pool.sleepers, 1, memory_order_seq_cst);
+    uint64_t epoch = pool.wake_epoch;
+    if (!any_work() && !atomic_load(&pool.quit))
+    {
+        while (epoch == pool.wake_epoch)
+            cnd_wait(&pool.wake, &pool.lock);
+    }
+    atomic_fetch_sub_explicit(&pool.sleepers, 1, memory_order_relaxed);
+    mtx_unlock(&pool.lock);
+}
+
+static void job_lock(Job *job)
+{
+    while (atomic_flag_test_and_set_explicit(&job->lock, memory_order_acquire))
+        thrd_yield();
+}
+
+static void job_unlock(Job *job)
+{
+    atomic_flag_clear_explicit(&job->lock, memory_order_release);
+}
+
+static JobHandle job_handle(uint32_t index, uint32_t generation)
+{
+    return ((JobHandle)generation << 32) | index;
 }
 
-void job_queue_init(JobQueue *q)
+/* Slot and generation a handle was issued for, false for handles no spawn returned. */
+static bool job_lookup(JobHandle handle, Job **job, uint32_t *generation)
 {
-    q->capacity = 64; // initial capacity
-    q->data = malloc(sizeof(QueuedJob) * q->capacity);
-    q->head = q->tail = q->count = 0;
+    uint32_t index = (uint32_t)handle;
+    *generation = (uint32_t)(handle >> 32);
+    if (!pool.jobs || index >= MAX_JOBS || !(*generation & 1u))
+        return false;
+    *job = &pool.jobs[index];
+    return true;
 }
 
-void job_queue_free(JobQueue *q)
+static void job_execute(uint32_t index);
+
+static void job_schedule(uint32_t index)
 {
-    free(q->data);
-    q->data = NULL;
-    q->count = q->capacity = q->head = q->tail = 0;
+    if (!pool.worker_count)
+    {
+        job_execute(index); // no workers could be started, run synchronously
+        return;
+    }
+    // Jobs spawned by a job stay on that worker's deque for the others to steal
+    if (worker_index < 0 || !deque_push(&pool.workers[worker_index].deque, index))
+        mpmc_push(&pool.injection, index);
+    wake_one();
 }
 
-void job_queue_push(JobQueue *q, int (*fn)(void *), void *user_data)
+static void job_execute(uint32_t index)
 {
-    if (q->count >= q->capacity)
+    Job *job = &pool.jobs[index];
+    atomic_store_explicit(&job->result, job->fn(job->user_data), memory_order_relaxed);
+
+    // Publish completion and close the dependent list in one step, see job_add_dependent
+    job_lock(job);
+    uint32_t link = job->continuations;
+    job->continuations = LINK_NONE;
+    atomic_fetch_add_explicit(&job->generation, 1, memory_order_release);
+    job_unlock(job);
+
+    while (link != LINK_NONE)
     {
-        size_t new_capacity = q->capacity * 2;
-        QueuedJob *new_data = malloc(sizeof(QueuedJob) * new_capacity);
+        JobLink edge = pool.links[link];
+        mpmc_push(&pool.free_links, link);
+        if (atomic_fetch_sub_explicit(&pool.jobs[edge.job].pending, 1, memory_order_acq_rel) == 1)
+            job_schedule(edge.job);
+        link = edge.next;
+    }
+    mpmc_push(&pool.free_jobs, index);
+}
 
-        // Copy circular queue into linear layout
-        for (size_t i = 0; i < q->count; ++i)
-            new_data[i] = q->data[(q->head + i) % q->capacity];
+/* Runs one queued job on the calling thread, false if there was nothing to take. */
+static bool help_one(void)
+{
+    // Own work first (LIFO, cache-warm), then outside submissions, then other workers
+    uint32_t job = JOB_NONE;
+    if (worker_index >= 0)
+        job = deque_pop(&pool.workers[worker_index].deque);
+    if (job == JOB_NONE && !mpmc_pop(&pool.injection, &job))
+        job = steal_any(worker_index);
+    if (job == JOB_NONE)
+        return false;
+    job_execute(job);
+    return true;
+}
 
-        free(q->data);
-        q->data = new_data;
-        q->head = 0;
-        q->tail = q->count;
-        q->capacity = new_capacity;
+static int worker_entry(void *arg)
+{
+    worker_index = (int)(intptr_t)arg;
+    for (;;)
+    {
+        if (help_one())
+            continue;
+        // Jobs still queued at shutdown are run before the workers exit
+        if (atomic_load(&pool.quit) && !any_work())
+            return 0;
+        worker_sleep();
     }
+}
+
+static int cpu_count(void)
+{
+#ifdef _WIN32
+    SYSTEM_INFO info;
+    GetSystemInfo(&info);
+    return (int)info.dwNumberOfProcessors;
+#else
+    long n = sysconf(_SC_NPROCESSORS_ONLN);
+    return n > 0 ? (int)n : 1;
+#endif
+}
+
+static uint32_t job_alloc(int (*fn)(void *), void *user_data)
+{
+    uint32_t index;
+    // Slab exhausted: run other jobs until one finishes and frees its slot
+    while (!mpmc_pop(&pool.free_jobs, &index))
+        if (!help_one())
+            thrd_yield();
+
+    Job *job = &pool.jobs[index];
+    // Odd generation marks the slot live before anything in it changes (thread_job_wait reads it seqlock-style)
+    atomic_fetch_add_explicit(&job->generation, 1, memory_order_relaxed);
+    atomic_thread_fence(memory_order_release);
+    job->fn = fn;
+    job->user_data = user_data;
+    job->continuations = LINK_NONE;
+    atomic_store_explicit(&job->pending, 1, memory_order_relaxed);
+    return index;
+}
+
+/* Queues `dependent` to be released when `dep` finishes, false if `dep` already has. */
+static bool job_add_dependent(JobHandle dep, uint32_t dependent)
+{
+    Job *job;
+    uint32_t generation;
+    if (!job_lookup(dep, &job, &generation))
+        return false;
+    if (atomic_load_explicit(&job->generation, memory_order_acquire) != generation)
+        return false;
+
+    uint32_t link;
+    while (!mpmc_pop(&pool.free_links, &link))
+        if (!help_one())
+            thrd_yield();
+
+    // Checked again under the lock, job_execute bumps the generation while holding it
+    job_lock(job);
+    bool live = atomic_load_explicit(&job->generation, memory_order_relaxed) == generation;
+    if (live)
+    {
+        pool.links[link] = (JobLink){dependent, job->continuations};
+        job->continuations = link;
+    }
+    job_unlock(job);
+    if (!live)
+        mpmc_push(&pool.free_links, link);
+    return live;
+}
+
+JobHandle thread_spawn_after(int (*fn)(void *), void *user_data, const JobHandle *deps, size_t dep_count)
+{
+    if (!pool.jobs)
+    {
+        // Job pool failed to allocate, nothing can be pending either
+        fn(user_data);
+        return JOB_INVALID_HANDLE;
+    }
+    uint32_t index = job_alloc(fn, user_data);
+    Job *job = &pool.jobs[index];
+    JobHandle handle = job_handle(index, atomic_load_explicit(&job->generation, memory_order_relaxed));
+
+    for (size_t i = 0; i < dep_count; i++)
+    {
+        // Count the edge first, the dependency may finish as soon as it is linked
+        atomic_fetch_add_explicit(&job->pending, 1, memory_order_relaxed);
+        if (!job_add_dependent(deps[i], index))
+            atomic_fetch_sub_explicit(&job->pending, 1, memory_order_relaxed);
+    }
+    if (atomic_fetch_sub_explicit(&job->pending, 1, memory_order_acq_rel) == 1)
+        job_schedule(index);
+    return handle;
+}
+
+JobHandle thread_spawn(int (*fn)(void *), void *user_data)
+{
+    return thread_spawn_after(fn, user_data, NULL, 0);
+}
+
+bool thread_job_done(JobHandle handle)
+{
+    Job *job;
+    uint32_t generation;
+    if (!job_lookup(handle, &job, &generation))
+        return true;
+    return atomic_load_explicit(&job->generation, memory_order_acquire) != generation;
+}
+
+bool thread_job_wait(JobHandle handle, int *result)
+{
+    Job *job;
+    uint32_t generation;
+    if (!job_lookup(handle, &job, &generation))
+        return false;
+
+    // Help instead of blocking, the job we wait on may be queued behind others
+    while (!thread_job_done(handle))
+        if (!help_one())
+            thrd_yield();
+
+    uint32_t before = atomic_load_explicit(&job->generation, memory_order_acquire);
+    int value = atomic_load_explicit(&job->result, memory_order_relaxed);
+    atomic_thread_fence(memory_order_acquire);
+    uint32_t after = atomic_load_explicit(&job->generation, memory_order_relaxed);
+    if (before != generation + 1 || after != before)
+        return false; // slot already reused by a later spawn, the result is gone
+    if (result)
+        *result = value;
+    return true;
+}
+
+// --- PARALLEL ALGORITHMS ---
+
+#define PARALLEL_CHUNKS_PER_THREAD 8 // automatic grain: chunks per participant, for load balance
+#define RADIX_BLOCK_MIN 16384        // keys per radix block, below this blocks cost more than they save
+#define RADIX_BLOCKS_PER_THREAD 2
+
+/* `count` indexed tasks pulled off a shared counter by the caller and its helper jobs. */
+typedef struct
+{
+    _Atomic size_t next;
+    size_t count;
+    void (*fn)(size_t task, void *ctx);
+    void *ctx;
+} ParallelRun;
+
+static int parallel_entry(void *arg)
+{
+    ParallelRun *run = arg;
+    size_t task;
+    while ((task = atomic_fetch_add_explicit(&run->next, 1, memory_order_relaxed)) < run->count)
+        run->fn(task, run->ctx);
+    return 0;
+}
+
+/* Runs fn(0..count-1) across the pool and returns once all have finished. */
+static void parallel_run(size_t count, void (*fn)(size_t task, void *ctx), void *ctx)
+{
+    ParallelRun run = {.count = count, .fn = fn, .ctx = ctx};
+    atomic_init(&run.next, 0);
+
+    // The caller works too, so one helper fewer than tasks is enough
+    size_t helpers = count ? count - 1 : 0;
+    if (helpers > (size_t)pool.worker_count)
+        helpers = (size_t)pool.worker_count;
+    JobHandle handles[MAX_WORKERS];
+    for (size_t i = 0; i < helpers; i++)
+        handles[i] = thread_spawn(parallel_entry, &run);
+    parallel_entry(&run);
+
+    // `run` lives on this stack, so every helper must be done with it, late starters find no task
+    for (size_t i = 0; i < helpers; i++)
+        thread_job_wait(handles[i], NULL);
+}
+
+static size_t parallel_grain(size_t count, size_t grain)
+{
+    if (grain)
+        return grain;
+    size_t chunks = (size_t)(pool.worker_count + 1) * PARALLEL_CHUNKS_PER_THREAD;
+    grain = count / chunks;
+    return grain ? grain : 1;
+}
+
+/* Chunks of `grain` covering `count` indices; written so a huge grain cannot overflow. */
+static size_t parallel_chunks(size_t count, size_t grain)
+{
+    return count / grain + (count % grain != 0);
+}
+
+typedef struct
+{
+    size_t begin, end, grain;
+    ThreadRangeFn fn;
+    void *user_data;
+} ParallelFor;
+
+static void parallel_for_chunk(size_t task, void *ctx)
+{
+    ParallelFor *pf = ctx;
+    size_t lo = pf->begin + task * pf->grain;
+    size_t hi = pf->end - lo > pf->grain ? lo + pf->grain : pf->end;
+    pf->fn(lo, hi, pf->user_data);
+}
 
-    q->data[q->tail] = (QueuedJob){fn, user_data};
-    q->tail = (q->tail + 1) % q->capacity;
-    q->count++;
+void thread_parallel_for(size_t begin, size_t end, size_t grain, ThreadRangeFn fn, void *user_data)
+{
+    if (end <= begin)
+        return;
+    ParallelFor pf = {begin, end, parallel_grain(end - begin, grain), fn, user_data};
+    parallel_run(parallel_chunks(end - begin, pf.grain), parallel_for_chunk, &pf);
+}
+
+typedef struct
+{
+    size_t begin, end, grain, value_size;
+    const void *identity;
+    ThreadReduceFn reduce;
+    unsigned char *partials; // one value per chunk
+    void *user_data;
+} ParallelReduce;
+
+static void parallel_reduce_chunk(size_t task, void *ctx)
+{
+    ParallelReduce *pr = ctx;
+    size_t lo = pr->begin + task * pr->grain;
+    size_t hi = pr->end - lo > pr->grain ? lo + pr->grain : pr->end;
+    void *acc = pr->partials + task * pr->value_size;
+    memcpy(acc, pr->identity, pr->value_size);
+    pr->reduce(lo, hi, acc, pr->user_data);
 }
 
-int job_queue_pop(JobQueue *q, QueuedJob *out)
+bool thread_parallel_reduce(size_t begin, size_t end, size_t grain, size_t value_size, const void *identity,
+                            ThreadReduceFn reduce, ThreadCombineFn combine, void *result, void *user_data)
 {
-    if (q->count == 0)
-        return 0;
+    memcpy(result, identity, value_size);
+    if (end <= begin)
+        return true;
+    ParallelReduce pr = {begin, end, parallel_grain(end - begin, grain), value_size, identity, reduce, NULL, user_data};
+    size_t chunks = parallel_chunks(end - begin, pr.grain);
+    pr.partials = malloc(chunks * value_size);
+    if (!pr.partials)
+        return false;
+    parallel_run(chunks, parallel_reduce_chunk, &pr);
 
-    *out = q->data[q->head];
-    q->head = (q->head + 1) % q->capacity;
-    q->count--;
-    return 1;
+    // Partials are combined in chunk order, so the result does not depend on which worker ran what
+    for (size_t c = 0; c < chunks; c++)
+        combine(result, pr.partials + c * value_size, user_data);
+    free(pr.partials);
+    return true;
 }
 
-static int try_start_queued_job()
+typedef struct
+{
+    const unsigned char *in;
+    unsigned char *out;
+    size_t count, grain, value_size;
+    const void *identity;
+    ThreadCombineFn combine;
+    unsigned char *carry;   // per chunk: total after pass one, starting offset for pass two
+    unsigned char *scratch; // per chunk temporary for in-place exclusive scans
+    bool inclusive;
+    void *user_data;
+} ParallelScan;
+
+static void parallel_scan_total(size_t task, void *ctx)
 {
-    if (job_queue.count == 0)
-        return 0;
+    ParallelScan *ps = ctx;
+    size_t lo = task * ps->grain;
+    size_t hi = ps->count - lo > ps->grain ? lo + ps->grain : ps->count;
+    unsigned char *acc = ps->carry + task * ps->value_size;
+    memcpy(acc, ps->identity, ps->value_size);
+    for (size_t i = lo; i < hi; i++)
+        ps->combine(acc, ps->in + i * ps->value_size, ps->user_data);
+}
 
-    for (int i = 0; i < MAX_THREADS; i++)
+static void parallel_scan_apply(size_t task, void *ctx)
+{
+    ParallelScan *ps = ctx;
+    size_t vs = ps->value_size;
+    size_t lo = task * ps->grain;
+    size_t hi = ps->count - lo > ps->grain ? lo + ps->grain : ps->count;
+    unsigned char *acc = ps->carry + task * vs;
+    unsigned char *tmp = ps->scratch + task * vs;
+    for (size_t i = lo; i < hi; i++)
     {
-        if (!jobs[i].active)
+        if (ps->inclusive)
+        {
+            ps->combine(acc, ps->in + i * vs, ps->user_data);
+            memcpy(ps->out + i * vs, acc, vs);
+        }
+        else
         {
-            QueuedJob qj;
-            if (!job_queue_pop(&job_queue, &qj))
-                return 0;
-
-            jobs[i].active = 1;
-            jobs[i].finished = 0;
-            jobs[i].fn = qj.fn;
-            jobs[i].user_data = qj.user_data;
-            thrd_create(&jobs[i].handle, thread_entry, &jobs[i]);
-            return 1;
+            memcpy(tmp, ps->in + i * vs, vs); // `in` may alias `out`
+            memcpy(ps->out + i * vs, acc, vs);
+            ps->combine(acc, tmp, ps->user_data);
         }
     }
+}
 
-    return 0;
+static bool parallel_scan(const void *in, void *out, size_t count, size_t value_size, const void *identity,
+                          ThreadCombineFn combine, bool inclusive, void *user_data)
+{
+    if (!count)
+        return true;
+    ParallelScan ps = {in, out, count, parallel_grain(count, 0), value_size, identity, combine, NULL, NULL, inclusive, user_data};
+    size_t chunks = parallel_chunks(count, ps.grain);
+    ps.carry = malloc(chunks * value_size * 2);
+    if (!ps.carry)
+        return false;
+    ps.scratch = ps.carry + chunks * value_size;
+
+    // Pass one totals each chunk, then a serial exclusive scan over the totals gives every
+    // chunk its starting value, and pass two scans the chunks independently from there
+    if (chunks > 1)
+        parallel_run(chunks, parallel_scan_total, &ps);
+    unsigned char *running = ps.scratch; // chunk 0's scratch, free until pass two
+    memcpy(running, identity, value_size);
+    for (size_t c = 0; c < chunks; c++)
+    {
+        unsigned char *slot = ps.carry + c * value_size;
+        unsigned char *next = c + 1 < chunks ? ps.scratch + (c + 1) * value_size : NULL;
+        if (next)
+        {
+            // running + total of chunk c becomes chunk c+1's start, staged in its scratch slot
+            memcpy(next, running, value_size);
+            ps.combine(next, slot, user_data);
+        }
+        memcpy(slot, running, value_size);
+        running = next;
+    }
+    parallel_run(chunks, parallel_scan_apply, &ps);
+    free(ps.carry);
+    return true;
+}
+
+bool thread_inclusive_scan(const void *in, void *out, size_t count, size_t value_size, const void *identity,
+                           ThreadCombineFn combine, void *user_data)
+{
+    return parallel_scan(in, out, count, value_size, identity, combine, true, user_data);
+}
+
+bool thread_exclusive_scan(const void *in, void *out, size_t count, size_t value_size, const void *identity,
+                           ThreadCombineFn combine, void *user_data)
+{
+    return parallel_scan(in, out, count, value_size, identity, combine, false, user_data);
+}
+
+/*
+ * LSD radix sort, 8 bits per pass. Each pass splits the keys into fixed blocks: the blocks
+ * histogram their digit in parallel, a serial prefix over (digit, block) turns the counts into
+ * scatter offsets, and the blocks scatter in parallel. Blocks scatter in order within a digit,
+ * so every pass is stable and the payload follows its key.
+ */
+typedef struct
+{
+    const void *src;
+    void *dst;
+    const uint32_t *src_values;
+    uint32_t *dst_values;
+    size_t count, block_size;
+    size_t *hist; // [block][256]
+    unsigned shift;
+    bool wide;
+} RadixPass;
+
+static void radix_histogram(size_t block, void *ctx)
+{
+    RadixPass *rp = ctx;
+    size_t *hist = rp->hist + block * 256;
+    size_t lo = block * rp->block_size;
+    size_t hi = rp->count - lo > rp->block_size ? lo + rp->block_size : rp->count;
+    memset(hist, 0, sizeof(size_t) * 256);
+    if (rp->wide)
+    {
+        const uint64_t *keys = rp->src;
+        for (size_t i = lo; i < hi; i++)
+            hist[(keys[i] >> rp->shift) & 0xFF]++;
+    }
+    else
+    {
+        const uint32_t *keys = rp->src;
+        for (size_t i = lo; i < hi; i++)
+            hist[(keys[i] >> rp->shift) & 0xFF]++;
+    }
+}
+
+static void radix_scatter(size_t block, void *ctx)
+{
+    RadixPass *rp = ctx;
+    size_t *offsets = rp->hist + block * 256;
+    size_t lo = block * rp->block_size;
+    size_t hi = rp->count - lo > rp->block_size ? lo + rp->block_size : rp->count;
+    if (rp->wide)
+    {
+        const uint64_t *src = rp->src;
+        uint64_t *dst = rp->dst;
+        for (size_t i = lo; i < hi; i++)
+        {
+            size_t at = offsets[(src[i] >> rp->shift) & 0xFF]++;
+            dst[at] = src[i];
+            if (rp->dst_values)
+                rp->dst_values[at] = rp->src_values[i];
+        }
+    }
+    else
+    {
+        const uint32_t *src = rp->src;
+        uint32_t *dst = rp->dst;
+        for (size_t i = lo; i < hi; i++)
+        {
+            size_t at = offsets[(src[i] >> rp->shift) & 0xFF]++;
+            dst[at] = src[i];
+            if (rp->dst_values)
+                rp->dst_values[at] = rp->src_values[i];
+        }
+    }
 }
 
-void thread_spawn(int (*fn)(void *), void *user_data)
+static bool radix_sort(void *keys, uint32_t *values, size_t count, bool wide)
 {
-    for (int i = 0; i < MAX_THREADS; i++)
+    if (count < 2)
+        return true;
+    size_t key_size = wide ? sizeof(uint64_t) : sizeof(uint32_t);
+    size_t blocks = count / RADIX_BLOCK_MIN;
+    size_t max_blocks = (size_t)(pool.worker_count + 1) * RADIX_BLOCKS_PER_THREAD;
+    if (blocks > max_blocks)
+        blocks = max_blocks;
+    if (!blocks)
+        blocks = 1;
+
+    void *key_buf = malloc(count * key_size);
+    uint32_t *value_buf = values ? malloc(count * sizeof(uint32_t)) : NULL;
+    size_t *hist = malloc(blocks * 256 * sizeof(size_t));
+    if (!key_buf || (values && !value_buf) || !hist)
+    {
+        free(key_buf);
+        free(value_buf);
+        free(hist);
+        return false;
+    }
+
+    RadixPass rp = {keys, key_buf, values, value_buf, count, (count + blocks - 1) / blocks, hist, 0, wide};
+    for (rp.shift = 0; rp.shift < key_size * 8; rp.shift += 8)
     {
-        if (!jobs[i].active)
+        parallel_run(blocks, radix_histogram, &rp);
+
+        // Turn counts into scatter offsets, digit-major so block order is kept within a digit
+        size_t running = 0;
+        bool trivial = false;
+        for (size_t d = 0; d < 256 && !trivial; d++)
         {
-            jobs[i].active = 1;
-            jobs[i].finished = 0;
-            jobs[i].fn = fn;
-            jobs[i].user_data = user_data;
-            thrd_create(&jobs[i].handle, thread_entry, &jobs[i]);
-            return;
+            size_t before = running;
+            for (size_t b = 0; b < blocks; b++)
+            {
+                size_t n = hist[b * 256 + d];
+                hist[b * 256 + d] = running;
+                running += n;
+            }
+            trivial = running - before == count; // every key has this digit, nothing to move
         }
+        if (trivial)
+            continue;
+        parallel_run(blocks, radix_scatter, &rp);
+
+        const void *src = rp.src;
+        rp.src = rp.dst;
+        rp.dst = (void *)src;
+        const uint32_t *src_values = rp.src_values;
+        rp.src_values = rp.dst_values;
+        rp.dst_values = (uint32_t *)src_values;
     }
 
-    // No thread slot available — queue it
-    job_queue_push(&job_queue, fn, user_data);
+    // An odd number of moving passes leaves the result in the scratch buffers
+    if (rp.src != keys)
+    {
+        memcpy(keys, rp.src, count * key_size);
+        if (values)
+            memcpy(values, rp.src_values, count * sizeof(uint32_t));
+    }
+    free(key_buf);
+    free(value_buf);
+    free(hist);
+    return true;
 }
 
-int update(CoreContext *ctx)
+bool thread_radix_sort32(uint32_t *keys, uint32_t *values, size_t count)
 {
-    (void)ctx;
+    return radix_sort(keys, values, count, false);
+}
+
+bool thread_radix_sort64(uint64_t *keys, uint32_t *values, size_t count)
+{
+    return radix_sort(keys, values, count, true);
+}
+
+// --- TASK GRAPHS ---
+
+typedef struct
+{
+    uint32_t from;
+    uint32_t to;
+} GraphEdge;
+
+typedef struct
+{
+    int (*fn)(void *);
+    void *user_data;
+    ThreadTaskGraph *graph;
+    uint32_t first_successor; // into graph->successors
+    uint32_t successor_count;
+    uint32_t dependency_count;
+    _Atomic uint32_t pending; // reset to dependency_count by every submit
+} GraphNode;
+
+struct ThreadTaskGraph
+{
+    GraphNode *nodes;
+    uint32_t node_count;
+    uint32_t node_capacity;
+    GraphEdge *edges; // as recorded, turned into `successors` by compile
+    uint32_t edge_count;
+    uint32_t edge_capacity;
+    uint32_t *successors;
+    uint32_t *order; // topological, the dependency-free roots first
+    uint32_t root_count;
+    bool compiled;
+    _Atomic uint32_t remaining; // nodes of the current submission not yet finished
+};
+
+ThreadTaskGraph *thread_graph_create(void)
+{
+    return calloc(1, sizeof(ThreadTaskGraph));
+}
+
+void thread_graph_destroy(ThreadTaskGraph *graph)
+{
+    if (!graph)
+        return;
+    thread_graph_wait(graph);
+    free(graph->nodes);
+    free(graph->edges);
+    free(graph->successors);
+    free(graph->order);
+    free(graph);
+}
+
+static bool graph_idle(ThreadTaskGraph *graph)
+{
+    return atomic_load_explicit(&graph->remaining, memory_order_acquire) == 0;
+}
+
+uint32_t thread_graph_add(ThreadTaskGraph *graph, int (*fn)(void *), void *user_data)
+{
+    if (!graph_idle(graph) || graph->node_count == THREAD_GRAPH_INVALID_NODE)
+        return THREAD_GRAPH_INVALID_NODE;
+    if (graph->node_count >= graph->node_capacity)
+    {
+        uint32_t capacity = graph->node_capacity ? graph->node_capacity * 2 : 16;
+        GraphNode *nodes = realloc(graph->nodes, sizeof(GraphNode) * capacity);
+        if (!nodes)
+            return THREAD_GRAPH_INVALID_NODE;
+        graph->nodes = nodes;
+        graph->node_capacity = capacity;
+    }
+    uint32_t id = graph->node_count++;
+    GraphNode *node = &graph->nodes[id];
+    memset(node, 0, sizeof(*node));
+    node->fn = fn;
+    node->user_data = user_data;
+    node->graph = graph;
+    graph->compiled = false;
+    return id;
+}
+
+bool thread_graph_depend(ThreadTaskGraph *graph, uint32_t node, uint32_t dependency)
+{
+    if (!graph_idle(graph) || node >= graph->node_count || dependency >= graph->node_count || node == dependency)
+        return false;
+    if (graph->edge_count >= graph->edge_capacity)
+    {
+        uint32_t capacity = graph->edge_capacity ? graph->edge_capacity * 2 : 16;
+        GraphEdge *edges = realloc(graph->edges, sizeof(GraphEdge) * capacity);
+        if (!edges)
+            return false;
+        graph->edges = edges;
+        graph->edge_capacity = capacity;
+    }
+    graph->edges[graph->edge_count++] = (GraphEdge){dependency, node};
+    graph->compiled = false;
+    return true;
+}
 
-    for (int i = 0; i < MAX_THREADS; i++)
+bool thread_graph_compile(ThreadTaskGraph *graph)
+{
+    if (!graph_idle(graph))
+        return false;
+    uint32_t n = graph->node_count;
+    uint32_t *successors = malloc(sizeof(uint32_t) * (graph->edge_count ? graph->edge_count : 1));
+    uint32_t *order = malloc(sizeof(uint32_t) * (n ? n : 1));
+    uint32_t *indegree = malloc(sizeof(uint32_t) * (n ? n : 1));
+    if (!successors || !order || !indegree)
     {
-        if (jobs[i].active && jobs[i].finished)
+        free(successors);
+        free(order);
+        free(indegree);
+        return false;
+    }
+
+    // Successor lists as one array grouped by node (counting sort of the edges by source)
+    for (uint32_t i = 0; i < n; i++)
+    {
+        graph->nodes[i].successor_count = 0;
+        graph->nodes[i].dependency_count = 0;
+    }
+    for (uint32_t e = 0; e < graph->edge_count; e++)
+    {
+        graph->nodes[graph->edges[e].from].successor_count++;
+        graph->nodes[graph->edges[e].to].dependency_count++;
+    }
+    uint32_t offset = 0;
+    for (uint32_t i = 0; i < n; i++)
+    {
+        graph->nodes[i].first_successor = offset;
+        offset += graph->nodes[i].successor_count;
+        graph->nodes[i].successor_count = 0; // refilled below
+    }
+    for (uint32_t e = 0; e < graph->edge_count; e++)
+    {
+        GraphNode *from = &graph->nodes[graph->edges[e].from];
+        successors[from->first_successor + from->successor_count++] = graph->edges[e].to;
+    }
+
+    // Kahn's algorithm; seeding it with every root first leaves the roots as a prefix of `order`
+    uint32_t head = 0, tail = 0;
+    for (uint32_t i = 0; i < n; i++)
+    {
+        indegree[i] = graph->nodes[i].dependency_count;
+        if (!indegree[i])
+            order[tail++] = i;
+    }
+    uint32_t roots = tail;
+    while (head < tail)
+    {
+        GraphNode *node = &graph->nodes[order[head++]];
+        for (uint32_t s = 0; s < node->successor_count; s++)
         {
-            thrd_join(jobs[i].handle, NULL);
-            jobs[i].active = 0;
+            uint32_t next = successors[node->first_successor + s];
+            if (!--indegree[next])
+                order[tail++] = next;
         }
     }
+    free(indegree);
+    if (tail != n)
+    {
+        // Cycle, the nodes on it never reached indegree 0
+        free(successors);
+        free(order);
+        return false;
+    }
+
+    free(graph->successors);
+    free(graph->order);
+    graph->successors = successors;
+    graph->order = order;
+    graph->root_count = roots;
+    graph->compiled = true;
+    return true;
+}
+
+bool thread_graph_set_data(ThreadTaskGraph *graph, uint32_t node, void *user_data)
+{
+    if (!graph_idle(graph) || node >= graph->node_count)
+        return false;
+    graph->nodes[node].user_data = user_data;
+    return true;
+}
+
+static int graph_node_entry(void *arg)
+{
+    GraphNode *node = arg;
+    ThreadTaskGraph *graph = node->graph;
+    node->fn(node->user_data);
+
+    // Release successors onto this worker's deque, they usually want what this node just wrote
+    for (uint32_t s = 0; s < node->successor_count; s++)
+    {
+        GraphNode *next = &graph->nodes[graph->successors[node->first_successor + s]];
+        if (atomic_fetch_sub_explicit(&next->pending, 1, memory_order_acq_rel) == 1)
+            thread_spawn(graph_node_entry, next);
+    }
+    // Last touch of the graph, a waiter may free it right after
+    atomic_fetch_sub_explicit(&graph->remaining, 1, memory_order_release);
+    return 0;
+}
+
+bool thread_graph_submit(ThreadTaskGraph *graph)
+{
+    if (!graph->compiled || !graph_idle(graph))
+        return false;
+    if (!graph->node_count)
+        return true;
 
-    // Try to start any queued jobs
-    while (try_start_queued_job())
+    if (!pool.worker_count || !pool.jobs)
     {
+        // No pool: the topological order is already a valid serial schedule
+        for (uint32_t i = 0; i < graph->node_count; i++)
+        {
+            GraphNode *node = &graph->nodes[graph->order[i]];
+            node->fn(node->user_data);
+        }
+        return true;
     }
 
+    for (uint32_t i = 0; i < graph->node_count; i++)
+        atomic_store_explicit(&graph->nodes[i].pending, graph->nodes[i].dependency_count, memory_order_relaxed);
+    atomic_store_explicit(&graph->remaining, graph->node_count, memory_order_release);
+    for (uint32_t i = 0; i < graph->root_count; i++)
+        thread_spawn(graph_node_entry, &graph->nodes[graph->order[i]]);
+    return true;
+}
+
+void thread_graph_wait(ThreadTaskGraph *graph)
+{
+    while (!graph_idle(graph))
+        if (!help_one())
+            thrd_yield();
+}
+
+int thread_worker_count(void)
+{
+    return pool.worker_count;
+}
+
+int update(CoreContext *ctx)
+{
+    (void)ctx;
     return 0;
 }
 
 int init(CoreContext *ctx)
 {
-    memset(jobs, 0, sizeof(jobs));
-    job_queue_init(&job_queue);
+    memset(&pool, 0, sizeof(pool));
+    mtx_init(&pool.lock, mtx_plain);
+    cnd_init(&pool.wake);
+    pool.jobs = calloc(MAX_JOBS, sizeof(Job));
+    pool.links = malloc(sizeof(JobLink) * MAX_LINKS);
+    if (!pool.jobs || !pool.links || !mpmc_init(&pool.free_jobs, MAX_JOBS) ||
+        !mpmc_init(&pool.free_links, MAX_LINKS) || !mpmc_init(&pool.injection, MAX_JOBS))
+    {
+        free(pool.jobs);
+        pool.jobs = NULL;
+        CC_LOG_ERROR(ctx, "Threads: failed to allocate the job pool, jobs will run synchronously");
+    }
+    else
+    {
+        for (uint32_t i = 0; i < MAX_JOBS; i++)
+        {
+            atomic_flag_clear(&pool.jobs[i].lock);
+            mpmc_push(&pool.free_jobs, i);
+        }
+        for (uint32_t i = 0; i < MAX_LINKS; i++)
+            mpmc_push(&pool.free_links, i);
+
+        // THREADS_WORKERS=N overrides the core count
+        const char *env = getenv("THREADS_WORKERS");
+        int wanted = env ? atoi(env) : cpu_count();
+        if (wanted < 1)
+            wanted = 1;
+        if (wanted > MAX_WORKERS)
+            wanted = MAX_WORKERS;
+
+        // Thieves scan every deque, so the count is fixed before any worker runs
+        pool.deque_count = wanted;
+        for (int i = 0; i < wanted; i++)
+        {
+            if (thrd_create(&pool.workers[i].handle, worker_entry, (void *)(intptr_t)i) != thrd_success)
+                break; // the remaining deques stay empty
+            pool.worker_count++;
+        }
+        if (pool.worker_count < wanted)
+            CC_LOG_WARN(ctx, "Threads: started %d of %d workers", pool.worker_count, wanted);
+    }
 
     // Job system
     CC_BIND(ctx, CC_THREAD_SPAWN, thread_spawn, sizeof(thread_spawn), false);
+    CC_BIND(ctx, CC_THREAD_SPAWN_AFTER, thread_spawn_after, sizeof(thread_spawn_after), false);
+    CC_BIND(ctx, CC_THREAD_JOB_DONE, thread_job_done, sizeof(thread_job_done), false);
+    CC_BIND(ctx, CC_THREAD_JOB_WAIT, thread_job_wait, sizeof(thread_job_wait), false);
+    CC_BIND(ctx, CC_THREAD_WORKER_COUNT, thread_worker_count, sizeof(thread_worker_count), false);
+
+    // Parallel algorithms
+    CC_BIND(ctx, CC_THREAD_PARALLEL_FOR, thread_parallel_for, sizeof(thread_parallel_for), false);
+    CC_BIND(ctx, CC_THREAD_PARALLEL_REDUCE, thread_parallel_reduce, sizeof(thread_parallel_reduce), false);
+    CC_BIND(ctx, CC_THREAD_INCLUSIVE_SCAN, thread_inclusive_scan, sizeof(thread_inclusive_scan), false);
+    CC_BIND(ctx, CC_THREAD_EXCLUSIVE_SCAN, thread_exclusive_scan, sizeof(thread_exclusive_scan), false);
+    CC_BIND(ctx, CC_THREAD_RADIX_SORT32, thread_radix_sort32, sizeof(thread_radix_sort32), false);
+    CC_BIND(ctx, CC_THREAD_RADIX_SORT64, thread_radix_sort64, sizeof(thread_radix_sort64), false);
+
+    // Task graphs
+    CC_BIND(ctx, CC_THREAD_GRAPH_CREATE, thread_graph_create, sizeof(thread_graph_create), false);
+    CC_BIND(ctx, CC_THREAD_GRAPH_DESTROY, thread_graph_destroy, sizeof(thread_graph_destroy), false);
+    CC_BIND(ctx, CC_THREAD_GRAPH_ADD, thread_graph_add, sizeof(thread_graph_add), false);
+    CC_BIND(ctx, CC_THREAD_GRAPH_DEPEND, thread_graph_depend, sizeof(thread_graph_depend), false);
+    CC_BIND(ctx, CC_THREAD_GRAPH_COMPILE, thread_graph_compile, sizeof(thread_graph_compile), false);
+    CC_BIND(ctx, CC_THREAD_GRAPH_SET_DATA, thread_graph_set_data, sizeof(thread_graph_set_data), false);
+    CC_BIND(ctx, CC_THREAD_GRAPH_SUBMIT, thread_graph_submit, sizeof(thread_graph_submit), false);
+    CC_BIND(ctx, CC_THREAD_GRAPH_WAIT, thread_graph_wait, sizeof(thread_graph_wait), false);
 
     // Raw thread functions
     CC_BIND(ctx, CC_THREAD_CREATE, core_thrd_create, sizeof(core_thrd_create), false);
@@ -207,17 +1224,26 @@ int shutdown(CoreContext *ctx)
 {
     (void)ctx;
 
-    // Wait for all threads to finish
-    for (int i = 0; i < MAX_THREADS; i++)
-    {
-        if (jobs[i].active)
-        {
-            thrd_join(jobs[i].handle, NULL);
-            jobs[i].active = 0;
-        }
-    }
+    // Let the workers drain every queue, then join them
+    atomic_store(&pool.quit, true);
+    mtx_lock(&pool.lock);
+    pool.wake_epoch++;
+    cnd_broadcast(&pool.wake);
+    mtx_unlock(&pool.lock);
+    for (int i = 0; i < pool.worker_count; i++)
+        thrd_join(pool.workers[i].handle, NULL);
+    pool.worker_count = 0;
+    pool.deque_count = 0;
 
-    job_queue_free(&job_queue);
+    mpmc_free(&pool.injection);
+    mpmc_free(&pool.free_jobs);
+    mpmc_free(&pool.free_links);
+    free(pool.jobs);
+    free(pool.links);
+    pool.jobs = NULL;
+    pool.links = NULL;
+    mtx_destroy(&pool.lock);
+    cnd_destroy(&pool.wake);
     return 0;
 }
 
@@ -241,7 +1267,7 @@ int test_job(void* arg) {
 }
 
 int init(CoreContext* ctx) {
-    void (*spawn)(int (*)(void*), void*) = CC_GET(ctx, "thread::spawn");
+    thread_spawn_fn_t spawn = CC_GET(ctx, CC_THREAD_SPAWN);
 
     for (int i = 0; i < 40; i++) {
         spawn(test_job, "Hello from job");
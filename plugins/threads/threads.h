@@ -2,8 +2,9 @@
  * @file threads_plugin.h
  * @brief Exposes threading functionality to other plugins via CoreContext.
  *
- * This plugin provides a cooperative thread pool and job queue system, allowing plugins
- * to offload work to background threads. It wraps `tinycthread` for platform-agnostic threading.
+ * This plugin provides a persistent work-stealing worker pool (one worker per core,
+ * `THREADS_WORKERS=N` overrides it), allowing plugins to offload work to background threads.
+ * It wraps `tinycthread` for platform-agnostic threading.
  */
 
  #ifndef _THREADS_PLUGIN_H
@@ -22,9 +23,139 @@
  /** 
   * @brief Spawns a background thread.
   * 
-  * @signature void (*)(int (*fn)(void*), void* user_data)
+  * @signature JobHandle (*)(int (*fn)(void*), void* user_data)
   */
  #define CC_THREAD_SPAWN           "thread::spawn"
+
+ /**
+  * @brief Spawns a job that runs once all the given jobs have finished.
+  *
+  * @signature JobHandle (*)(int (*fn)(void*), void* user_data, const JobHandle* deps, size_t dep_count)
+  */
+ #define CC_THREAD_SPAWN_AFTER     "thread::spawn_after"
+
+ /**
+  * @brief Checks whether a job has finished.
+  *
+  * @signature bool (*)(JobHandle job)
+  */
+ #define CC_THREAD_JOB_DONE        "thread::job_done"
+
+ /**
+  * @brief Waits for a job, running other queued jobs meanwhile.
+  *
+  * @signature bool (*)(JobHandle job, int* result)
+  */
+ #define CC_THREAD_JOB_WAIT        "thread::job_wait"
+
+ /**
+  * @brief Number of pool workers.
+  *
+  * @signature int (*)(void)
+  */
+ #define CC_THREAD_WORKER_COUNT    "thread::worker_count"
+
+ // ---------------- Parallel Algorithms ----------------
+
+ /**
+  * @brief Splits a range into chunks and runs them across the pool.
+  *
+  * @signature void (*)(size_t begin, size_t end, size_t grain, ThreadRangeFn fn, void* user_data)
+  */
+ #define CC_THREAD_PARALLEL_FOR    "thread::parallel_for"
+
+ /**
+  * @brief Reduces a range in parallel chunks.
+  *
+  * @signature bool (*)(size_t begin, size_t end, size_t grain, size_t value_size, const void* identity, ThreadReduceFn reduce, ThreadCombineFn combine, void* result, void* user_data)
+  */
+ #define CC_THREAD_PARALLEL_REDUCE "thread::parallel_reduce"
+
+ /**
+  * @brief Parallel inclusive prefix scan.
+  *
+  * @signature bool (*)(const void* in, void* out, size_t count, size_t value_size, const void* identity, ThreadCombineFn combine, void* user_data)
+  */
+ #define CC_THREAD_INCLUSIVE_SCAN  "thread::inclusive_scan"
+
+ /**
+  * @brief Parallel exclusive prefix scan.
+  *
+  * @signature bool (*)(const void* in, void* out, size_t count, size_t value_size, const void* identity, ThreadCombineFn combine, void* user_data)
+  */
+ #define CC_THREAD_EXCLUSIVE_SCAN  "thread::exclusive_scan"
+
+ /**
+  * @brief Parallel stable radix sort of 32-bit keys with an optional payload.
+  *
+  * @signature bool (*)(uint32_t* keys, uint32_t* values, size_t count)
+  */
+ #define CC_THREAD_RADIX_SORT32    "thread::radix_sort32"
+
+ /**
+  * @brief Parallel stable radix sort of 64-bit keys with an optional payload.
+  *
+  * @signature bool (*)(uint64_t* keys, uint32_t* values, size_t count)
+  */
+ #define CC_THREAD_RADIX_SORT64    "thread::radix_sort64"
+
+ // ---------------- Task Graphs ----------------
+
+ /**
+  * @brief Creates an empty task graph.
+  *
+  * @signature ThreadTaskGraph* (*)(void)
+  */
+ #define CC_THREAD_GRAPH_CREATE    "thread::graph_create"
+
+ /**
+  * @brief Waits for a graph's submission and frees it.
+  *
+  * @signature void (*)(ThreadTaskGraph* graph)
+  */
+ #define CC_THREAD_GRAPH_DESTROY   "thread::graph_destroy"
+
+ /**
+  * @brief Records a node.
+  *
+  * @signature uint32_t (*)(ThreadTaskGraph* graph, int (*fn)(void*), void* user_data)
+  */
+ #define CC_THREAD_GRAPH_ADD       "thread::graph_add"
+
+ /**
+  * @brief Records that a node runs after another.
+  *
+  * @signature bool (*)(ThreadTaskGraph* graph, uint32_t node, uint32_t dependency)
+  */
+ #define CC_THREAD_GRAPH_DEPEND    "thread::graph_depend"
+
+ /**
+  * @brief Precomputes the schedule of a recorded graph.
+  *
+  * @signature bool (*)(ThreadTaskGraph* graph)
+  */
+ #define CC_THREAD_GRAPH_COMPILE   "thread::graph_compile"
+
+ /**
+  * @brief Replaces a node's user data before the next submission.
+  *
+  * @signature bool (*)(ThreadTaskGraph* graph, uint32_t node, void* user_data)
+  */
+ #define CC_THREAD_GRAPH_SET_DATA  "thread::graph_set_data"
+
+ /**
+  * @brief Runs a compiled graph once on the pool.
+  *
+  * @signature bool (*)(ThreadTaskGraph* graph)
+  */
+ #define CC_THREAD_GRAPH_SUBMIT    "thread::graph_submit"
+
+ /**
+  * @brief Waits for a graph's submission, running queued jobs meanwhile.
+  *
+  * @signature void (*)(ThreadTaskGraph* graph)
+  */
+ #define CC_THREAD_GRAPH_WAIT      "thread::graph_wait"
  
  // ---------------- Raw Thread Functions ----------------
  
@@ -69,19 +200,243 @@
   * @signature void (*)(void)
   */
  #define CC_THREAD_YIELD           "thread::raw::yield"
+
+ /**
+  * @brief Identifies a spawned job: slot generation in the high 32 bits, slot index in the low.
+  *
+  * Finished slots are reused oldest-first, so a handle stays answerable (done, result) until
+  * tens of thousands of later spawns have gone through its slot.
+  */
+ typedef uint64_t JobHandle;
+
+ #define JOB_INVALID_HANDLE 0
  
  /**
-  * @brief Spawns a background thread to run the given function with user data.
+  * @brief Runs the given function with user data on a pool worker.
   *
-  * If there is a free slot in the internal thread pool, the job runs in a background thread.
-  * If the pool is full, the job is either queued or optionally executed synchronously (based on implementation).
+  * Called from a job, the new job goes on the calling worker's own deque, where it runs next
+  * unless an idle worker steals it first. Called from any other thread, it goes on a shared
+  * lock-free injection queue. Idle workers are woken immediately. Jobs still queued at
+  * shutdown run before the workers exit. The job runs synchronously if no worker could be
+  * started. While all 65536 job slots are in flight the caller runs queued jobs until one
+  * frees up.
   *
   * @param fn         Function pointer of the form `int my_job(void* user_data)`.
   * @param user_data  Pointer to arbitrary user data passed into the job.
+  * @return Handle for thread_job_wait()/thread_job_done() or as a dependency of later jobs.
+  */
+ JobHandle thread_spawn(int (*fn)(void*), void* user_data);
+
+ typedef JobHandle (*thread_spawn_fn_t)(int (*fn)(void*), void* user_data);
+
+ /**
+  * @brief Like thread_spawn(), but the job is only queued once every job in `deps` has finished.
+  *
+  * A single dependency makes a continuation; several make a join (run B after A and C).
+  * Dependencies that have already finished, or are JOB_INVALID_HANDLE, are skipped. A job
+  * that finishes releases its dependents on the same worker, so a chain stays cache-warm.
+  *
+  * @param deps       Jobs to wait for, may be NULL when `dep_count` is 0.
+  * @param dep_count  Number of handles in `deps`.
+  */
+ JobHandle thread_spawn_after(int (*fn)(void*), void* user_data, const JobHandle* deps, size_t dep_count);
+
+ typedef JobHandle (*thread_spawn_after_fn_t)(int (*fn)(void*), void* user_data, const JobHandle* deps, size_t dep_count);
+
+ /**
+  * @brief Returns true once the job has finished. Invalid handles count as finished.
+  */
+ bool thread_job_done(JobHandle job);
+
+ typedef bool (*thread_job_done_fn_t)(JobHandle job);
+
+ /**
+  * @brief Waits until the job has finished and optionally fetches its return value.
+  *
+  * The waiting thread does not block: it runs queued jobs (its own deque first when called
+  * from a job, then the injection queue, then other workers' deques) until the job is done.
+  * Waiting from inside a job is therefore safe even with a single worker.
+  *
+  * @param result  Receives the job's return value, may be NULL.
+  * @return false for JOB_INVALID_HANDLE or if the slot was already reused, so the result is gone.
+  */
+ bool thread_job_wait(JobHandle job, int* result);
+
+ typedef bool (*thread_job_wait_fn_t)(JobHandle job, int* result);
+
+ /**
+  * @brief Returns the number of pool workers.
+  */
+ int thread_worker_count(void);
+
+ typedef int (*thread_worker_count_fn_t)(void);
+
+ /** @brief Processes the indices [begin, end) of one chunk. */
+ typedef void (*ThreadRangeFn)(size_t begin, size_t end, void* user_data);
+
+ /** @brief Folds the indices [begin, end) into `acc`, which starts out as the identity value. */
+ typedef void (*ThreadReduceFn)(size_t begin, size_t end, void* acc, void* user_data);
+
+ /** @brief `acc = acc op value` for an associative `op`; `acc` is on the left. */
+ typedef void (*ThreadCombineFn)(void* acc, const void* value, void* user_data);
+
+ /*
+  * All parallel algorithms block until done, with the calling thread taking chunks too and
+  * then helping like thread_job_wait(). They can therefore be nested inside jobs and run
+  * serially when the pool has no workers.
+  */
+
+ /**
+  * @brief Calls `fn` on consecutive chunks of [begin, end), spread over the pool.
+  *
+  * Chunks are handed out dynamically, so uneven chunk costs balance themselves.
+  *
+  * @param grain  Indices per chunk; 0 picks about 8 chunks per participating thread.
+  */
+ void thread_parallel_for(size_t begin, size_t end, size_t grain, ThreadRangeFn fn, void* user_data);
+
+ typedef void (*thread_parallel_for_fn_t)(size_t begin, size_t end, size_t grain, ThreadRangeFn fn, void* user_data);
+
+ /**
+  * @brief Reduces [begin, end) into `result`.
+  *
+  * Each chunk folds its indices with `reduce` into a private value that starts as `identity`.
+  * The chunk values are then combined in index order, so the result is deterministic for a
+  * fixed grain, even for floating point.
+  *
+  * @param grain       Indices per chunk, 0 for automatic.
+  * @param value_size  Size of the reduced value type.
+  * @param identity    Identity of `combine`, also the result for an empty range.
+  * @return false if the per-chunk values could not be allocated (`result` holds `identity`).
+  */
+ bool thread_parallel_reduce(size_t begin, size_t end, size_t grain, size_t value_size, const void* identity,
+                             ThreadReduceFn reduce, ThreadCombineFn combine, void* result, void* user_data);
+
+ typedef bool (*thread_parallel_reduce_fn_t)(size_t begin, size_t end, size_t grain, size_t value_size, const void* identity,
+                                             ThreadReduceFn reduce, ThreadCombineFn combine, void* result, void* user_data);
+
+ /**
+  * @brief out[i] = in[0] op ... op in[i]. `in` and `out` may be the same array.
+  *
+  * Two parallel passes over the data (chunk totals, then per-chunk scans from each chunk's
+  * offset), so `combine` runs about twice per element and must be associative.
+  *
+  * @return false if the per-chunk carries could not be allocated.
+  */
+ bool thread_inclusive_scan(const void* in, void* out, size_t count, size_t value_size, const void* identity,
+                            ThreadCombineFn combine, void* user_data);
+
+ typedef bool (*thread_inclusive_scan_fn_t)(const void* in, void* out, size_t count, size_t value_size, const void* identity,
+                                            ThreadCombineFn combine, void* user_data);
+
+ /**
+  * @brief out[0] = identity, out[i] = in[0] op ... op in[i-1]. `in` and `out` may be the same array.
+  */
+ bool thread_exclusive_scan(const void* in, void* out, size_t count, size_t value_size, const void* identity,
+                            ThreadCombineFn combine, void* user_data);
+
+ typedef bool (*thread_exclusive_scan_fn_t)(const void* in, void* out, size_t count, size_t value_size, const void* identity,
+                                            ThreadCombineFn combine, void* user_data);
+
+ /**
+  * @brief Sorts `keys` ascending in place with a stable LSD radix sort, 8 bits per pass.
+  *
+  * Passes where every key shares the digit are skipped. Allocates a scratch copy of the keys
+  * (and values) for the duration of the call.
+  *
+  * @param values  Payload permuted along with the keys (e.g. indices), may be NULL.
+  * @return false if the scratch buffers could not be allocated; the input is then untouched.
+  */
+ bool thread_radix_sort32(uint32_t* keys, uint32_t* values, size_t count);
+
+ typedef bool (*thread_radix_sort32_fn_t)(uint32_t* keys, uint32_t* values, size_t count);
+
+ /**
+  * @brief 64-bit version of thread_radix_sort32().
+  */
+ bool thread_radix_sort64(uint64_t* keys, uint32_t* values, size_t count);
+
+ typedef bool (*thread_radix_sort64_fn_t)(uint64_t* keys, uint32_t* values, size_t count);
+
+ /**
+  * @brief A job structure recorded once and replayed, typically every frame.
+  *
+  * Record nodes and edges, compile once, then per frame: optionally thread_graph_set_data()
+  * with the frame's data, thread_graph_submit() and thread_graph_wait(). Compiling computes
+  * a topological order, the successor lists and each node's dependency count, so a
+  * submission only resets the counters and spawns the roots (O(nodes), no allocation); each
+  * finishing node releases its successors onto its own worker's deque. Recording, compiling
+  * and setting data are refused while a submission is running. Without workers a submission
+  * runs the nodes in topological order on the caller.
+  */
+ typedef struct ThreadTaskGraph ThreadTaskGraph;
+
+ #define THREAD_GRAPH_INVALID_NODE UINT32_MAX
+
+ /**
+  * @brief Creates an empty task graph, NULL on allocation failure.
+  */
+ ThreadTaskGraph* thread_graph_create(void);
+
+ typedef ThreadTaskGraph* (*thread_graph_create_fn_t)(void);
+
+ /**
+  * @brief Waits for any running submission, then frees the graph. NULL is ignored.
+  */
+ void thread_graph_destroy(ThreadTaskGraph* graph);
+
+ typedef void (*thread_graph_destroy_fn_t)(ThreadTaskGraph* graph);
+
+ /**
+  * @brief Adds a node running `fn(user_data)`. The graph must be compiled again before the next submit.
+  *
+  * @return Node id (ids count up from 0), or THREAD_GRAPH_INVALID_NODE.
+  */
+ uint32_t thread_graph_add(ThreadTaskGraph* graph, int (*fn)(void*), void* user_data);
+
+ typedef uint32_t (*thread_graph_add_fn_t)(ThreadTaskGraph* graph, int (*fn)(void*), void* user_data);
+
+ /**
+  * @brief Makes `node` wait for `dependency` in every submission.
+  *
+  * @return false for unknown or identical nodes, during a submission, or on allocation failure.
+  */
+ bool thread_graph_depend(ThreadTaskGraph* graph, uint32_t node, uint32_t dependency);
+
+ typedef bool (*thread_graph_depend_fn_t)(ThreadTaskGraph* graph, uint32_t node, uint32_t dependency);
+
+ /**
+  * @brief Precomputes the schedule after recording.
+  *
+  * @return false if the dependencies form a cycle (the previous compile, if any, stays
+  *         unusable until the graph compiles again) or on allocation failure.
+  */
+ bool thread_graph_compile(ThreadTaskGraph* graph);
+
+ typedef bool (*thread_graph_compile_fn_t)(ThreadTaskGraph* graph);
+
+ /**
+  * @brief Sets the user data passed to a node from the next submission on.
+  */
+ bool thread_graph_set_data(ThreadTaskGraph* graph, uint32_t node, void* user_data);
+
+ typedef bool (*thread_graph_set_data_fn_t)(ThreadTaskGraph* graph, uint32_t node, void* user_data);
+
+ /**
+  * @brief Starts one run of a compiled graph and returns immediately (unless there are no workers).
+  *
+  * @return false if the graph is not compiled or its previous submission is still running.
+  */
+ bool thread_graph_submit(ThreadTaskGraph* graph);
+
+ typedef bool (*thread_graph_submit_fn_t)(ThreadTaskGraph* graph);
+
+ /**
+  * @brief Returns once the current submission has finished, helping like thread_job_wait().
   */
- void thread_spawn(int (*fn)(void*), void* user_data);
+ void thread_graph_wait(ThreadTaskGraph* graph);
 
- typedef void (*thread_spawn_fn_t)(int (*fn)(void*), void* user_data);
+ typedef void (*thread_graph_wait_fn_t)(ThreadTaskGraph* graph);
  
  #endif /* _THREADS_PLUGIN_H */
  
\ No newline at end of file
@@ -30,6 +30,7 @@ void core_run(Core* core)
     while (should_run && *should_run) {
         core_context_update(&core->context);
         plugin_manager_update(&core->manager,&core->context);
+        logger_update();
         if (should_hot_reload && *should_hot_reload)
         {
             plugin_manager_hot_reload(&core->manager,&core->context);
@@ -11,6 +11,9 @@ void core_context_new(CoreContext* ctx, int version)
     ctx->memory.get = mm_get;
     ctx->memory.bind = mm_bind;
     ctx->log = logger;
+    ctx->log_limited = logger_ratelimited;
+    ctx->log_level_floor = logger_level_floor();
+    ctx->log_set_level = logger_set_level;
 }
 
 void core_context_free(CoreContext* ctx)
@@ -1,4 +1,11 @@
 #include "../include/dt.h"
+#include <time.h>
+
+unsigned long long dt_now_ns() {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (unsigned long long)now.tv_sec * 1000000000ull + (unsigned long long)now.tv_nsec;
+}
 
 #ifdef RAYLIB_H
 
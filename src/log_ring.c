@@ -0,0 +1,367 @@
+#include "../include/log_ring.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#define LOG_RING_HEADER_SIZE 4096 // header gets its own page so data stays page aligned
+
+// ---------------- Platform file and mapping primitives ----------------
+
+#ifdef _WIN32
+
+static int ring_file_open(LogRing* ring, const char* path)
+{
+    HANDLE file = CreateFileA(path, GENERIC_READ | GENERIC_WRITE, FILE_SHARE_READ | FILE_SHARE_WRITE,
+                              NULL, OPEN_ALWAYS, FILE_ATTRIBUTE_NORMAL, NULL);
+    if (file == INVALID_HANDLE_VALUE)
+        return 1;
+    ring->file = (intptr_t)file;
+    return 0;
+}
+
+static int ring_file_size(const LogRing* ring, uint64_t* size)
+{
+    LARGE_INTEGER st;
+    if (!GetFileSizeEx((HANDLE)ring->file, &st))
+        return 1;
+    *size = (uint64_t)st.QuadPart;
+    return 0;
+}
+
+// Must not be called while a view of the file is mapped
+static int ring_file_resize(const LogRing* ring, size_t size)
+{
+    LARGE_INTEGER pos;
+    pos.QuadPart = (LONGLONG)size;
+    if (!SetFilePointerEx((HANDLE)ring->file, pos, NULL, FILE_BEGIN) || !SetEndOfFile((HANDLE)ring->file))
+        return 1;
+    return 0;
+}
+
+static unsigned char* ring_file_map(LogRing* ring, size_t size)
+{
+    uint64_t size64 = (uint64_t)size;
+    HANDLE mapping = CreateFileMappingA((HANDLE)ring->file, NULL, PAGE_READWRITE,
+                                        (DWORD)(size64 >> 32), (DWORD)size64, NULL);
+    if (!mapping)
+        return NULL;
+    void* view = MapViewOfFile(mapping, FILE_MAP_ALL_ACCESS, 0, 0, size);
+    if (!view)
+    {
+        CloseHandle(mapping);
+        return NULL;
+    }
+    ring->mapping = mapping;
+    return view;
+}
+
+static void ring_file_unmap(LogRing* ring, unsigned char* map, size_t size)
+{
+    FlushViewOfFile(map, size);
+    UnmapViewOfFile(map);
+    if (ring->mapping)
+    {
+        CloseHandle((HANDLE)ring->mapping);
+        ring->mapping = NULL;
+    }
+}
+
+static void ring_file_close(LogRing* ring)
+{
+    CloseHandle((HANDLE)ring->file);
+    ring->file = -1;
+}
+
+#else
+
+static int ring_file_open(LogRing* ring, const char* path)
+{
+    int fd = open(path, O_RDWR | O_CREAT, 0644);
+    if (fd < 0)
+        return 1;
+    ring->file = fd;
+    return 0;
+}
+
+static int ring_file_size(const LogRing* ring, uint64_t* size)
+{
+    struct stat st;
+    if (fstat((int)ring->file, &st) != 0)
+        return 1;
+    *size = (uint64_t)st.st_size;
+    return 0;
+}
+
+static int ring_file_resize(const LogRing* ring, size_t size)
+{
+    return ftruncate((int)ring->file, (off_t)size) != 0;
+}
+
+static unsigned char* ring_file_map(LogRing* ring, size_t size)
+{
+    void* map = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, (int)ring->file, 0);
+    return map == MAP_FAILED ? NULL : map;
+}
+
+static void ring_file_unmap(LogRing* ring, unsigned char* map, size_t size)
+{
+    (void)ring;
+    msync(map, size, MS_ASYNC);
+    munmap(map, size);
+}
+
+static void ring_file_close(LogRing* ring)
+{
+    close((int)ring->file);
+    ring->file = -1;
+}
+
+#endif
+
+// ---------------- Ring ----------------
+
+static void ring_map(LogRing* ring)
+{
+    ring->header = (LogRingHeader*)ring->map;
+    ring->data = ring->map + LOG_RING_HEADER_SIZE;
+}
+
+// Writes the data region oldest first
+static void ring_write_ordered(FILE* out, const unsigned char* data, size_t capacity, uint64_t written)
+{
+    if (written <= capacity)
+    {
+        fwrite(data, 1, (size_t)written, out);
+    }
+    else
+    {
+        size_t pos = (size_t)(written % capacity);
+        fwrite(data + pos, 1, capacity - pos, out);
+        fwrite(data, 1, pos, out);
+    }
+}
+
+// Copies the data region oldest first; returns the number of bytes copied
+static size_t ring_copy_ordered(unsigned char* out, const unsigned char* data, size_t capacity, uint64_t written)
+{
+    if (written <= capacity)
+    {
+        memcpy(out, data, (size_t)written);
+        return (size_t)written;
+    }
+    size_t pos = (size_t)(written % capacity);
+    memcpy(out, data + pos, capacity - pos);
+    memcpy(out + capacity - pos, data, pos);
+    return capacity;
+}
+
+// Shift <path>.1.log ... <path>.N.log up by one, dropping the oldest
+static void ring_shift_archives(const LogRing* ring)
+{
+    char from[300], to[300];
+    for (int i = ring->max_archives; i > 1; --i)
+    {
+        snprintf(from, sizeof(from), "%s.%d.log", ring->path, i - 1);
+        snprintf(to, sizeof(to), "%s.%d.log", ring->path, i);
+        remove(to); // rename does not replace an existing file on Windows
+        rename(from, to);
+    }
+}
+
+static void ring_rotate(LogRing* ring)
+{
+    if (ring->max_archives > 0 && ring->header->written > 0)
+    {
+        char archive[300];
+        ring_shift_archives(ring);
+        snprintf(archive, sizeof(archive), "%s.1.log", ring->path);
+        log_ring_export(ring, archive);
+    }
+    ring->header->written = 0;
+}
+
+// Copies a full ring aside for log_ring_archive(), or wraps if the last copy is still pending
+static void ring_rotate_deferred(LogRing* ring)
+{
+    if (!ring->archive)
+    {
+        ring_rotate(ring); // no copy buffer, archive in place
+        return;
+    }
+    if (atomic_load_explicit(&ring->archive_pending, memory_order_acquire))
+        return;
+    ring->archive_size = ring_copy_ordered(ring->archive, ring->data, (size_t)ring->header->capacity,
+                                           ring->header->written);
+    ring->header->written = 0;
+    atomic_store_explicit(&ring->archive_pending, 1, memory_order_release);
+}
+
+int log_ring_open(LogRing* ring, const char* path, size_t capacity, int max_archives)
+{
+    memset(ring, 0, sizeof(*ring));
+    atomic_init(&ring->archive_pending, 0);
+    ring->file = -1;
+    ring->max_archives = max_archives;
+    snprintf(ring->path, sizeof(ring->path), "%s", path);
+
+    if (ring_file_open(ring, path) != 0)
+        return 1;
+
+    size_t map_size = LOG_RING_HEADER_SIZE + capacity;
+    uint64_t file_size;
+    if (ring_file_size(ring, &file_size) != 0)
+    {
+        ring_file_close(ring);
+        return 1;
+    }
+
+    // An existing ring of a different size is archived before being resized
+    if (file_size >= sizeof(LogRingHeader) && file_size != map_size)
+    {
+        unsigned char* old = ring_file_map(ring, (size_t)file_size);
+        if (old)
+        {
+            ring->map = old;
+            ring->map_size = (size_t)file_size;
+            ring_map(ring);
+            if (ring->header->magic == LOG_RING_MAGIC &&
+                ring->header->capacity + LOG_RING_HEADER_SIZE == file_size)
+                ring_rotate(ring);
+            ring_file_unmap(ring, old, (size_t)file_size);
+            ring->map = NULL;
+        }
+    }
+
+    if (ring_file_resize(ring, map_size) != 0)
+    {
+        ring_file_close(ring);
+        return 1;
+    }
+
+    unsigned char* map = ring_file_map(ring, map_size);
+    if (!map)
+    {
+        ring_file_close(ring);
+        return 1;
+    }
+
+    ring->map = map;
+    ring->map_size = map_size;
+    ring_map(ring);
+
+    if (ring->header->magic != LOG_RING_MAGIC || ring->header->version != LOG_RING_VERSION ||
+        ring->header->capacity != capacity)
+    {
+        ring->header->magic = LOG_RING_MAGIC;
+        ring->header->version = LOG_RING_VERSION;
+        ring->header->capacity = capacity;
+        ring->header->written = 0;
+    }
+
+    // Rotations copy the ring here so the archive can be written outside the writers' lock
+    if (max_archives > 0)
+        ring->archive = malloc(capacity);
+    return 0;
+}
+
+void log_ring_write(LogRing* ring, const char* data, size_t len)
+{
+    if (!ring->map)
+        return;
+
+    size_t capacity = (size_t)ring->header->capacity;
+    if (len > capacity)
+    {
+        data += len - capacity;
+        len = capacity;
+    }
+
+    if (ring->max_archives > 0 && ring->header->written + len > capacity)
+        ring_rotate_deferred(ring);
+
+    size_t pos = (size_t)(ring->header->written % capacity);
+    size_t first = capacity - pos < len ? capacity - pos : len;
+    memcpy(ring->data + pos, data, first);
+    memcpy(ring->data, data + first, len - first);
+    ring->header->written += len;
+}
+
+void log_ring_archive(LogRing* ring)
+{
+    if (!atomic_load_explicit(&ring->archive_pending, memory_order_acquire))
+        return;
+
+    char archive[300];
+    ring_shift_archives(ring);
+    snprintf(archive, sizeof(archive), "%s.1.log", ring->path);
+    FILE* out = fopen(archive, "w");
+    if (out)
+    {
+        fwrite(ring->archive, 1, ring->archive_size, out);
+        fclose(out);
+    }
+    atomic_store_explicit(&ring->archive_pending, 0, memory_order_release);
+}
+
+int log_ring_export(const LogRing* ring, const char* path)
+{
+    FILE* out = fopen(path, "w");
+    if (!out)
+        return 1;
+    ring_write_ordered(out, ring->data, (size_t)ring->header->capacity, ring->header->written);
+    fclose(out);
+    return 0;
+}
+
+int log_ring_dump(const char* path, FILE* out)
+{
+    FILE* in = fopen(path, "rb");
+    if (!in)
+        return 1;
+
+    LogRingHeader header;
+    if (fread(&header, sizeof(header), 1, in) != 1 || header.magic != LOG_RING_MAGIC ||
+        header.version != LOG_RING_VERSION || header.capacity == 0 || header.capacity > SIZE_MAX)
+    {
+        fclose(in);
+        return 1;
+    }
+
+    unsigned char* data = malloc((size_t)header.capacity);
+    if (!data || fseek(in, LOG_RING_HEADER_SIZE, SEEK_SET) != 0 ||
+        fread(data, 1, (size_t)header.capacity, in) != (size_t)header.capacity)
+    {
+        free(data);
+        fclose(in);
+        return 1;
+    }
+
+    ring_write_ordered(out, data, (size_t)header.capacity, header.written);
+    free(data);
+    fclose(in);
+    return 0;
+}
+
+void log_ring_close(LogRing* ring)
+{
+    log_ring_archive(ring);
+    free(ring->archive);
+    ring->archive = NULL;
+    if (ring->map)
+    {
+        ring_file_unmap(ring, ring->map, ring->map_size);
+        ring->map = NULL;
+    }
+    if (ring->file != -1)
+        ring_file_close(ring);
+}
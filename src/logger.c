@@ -1,19 +1,111 @@
 #include "../include/logger.h"
+#include "../include/log_ring.h"
 
 #ifdef _WIN32
 #include <direct.h>
+#include <windows.h>
 #define mkdir(path, mode) _mkdir(path)
+#define log_yield() SwitchToThread()
 #else
 #include <sys/stat.h>
 #include <sys/types.h>
+#include <sched.h>
+#define log_yield() sched_yield()
 #endif
 
 #include <errno.h>
 #include <time.h>
 #include <stdarg.h>
 #include <string.h>
+#include <stdlib.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdatomic.h>
+#include <wchar.h>
+
+#define LOG_BINARY_BUFFER_SIZE (64 * 1024)
+#define LOG_FORMAT_TABLE_INITIAL 256
+#define LOG_LINE_SIZE 1024
+#define LOG_RING_PATH "logs/core.ring"
+#define LOG_SUPPRESSED_MAX 64
+#define LOG_SUPPRESSED_REPORT_NS 1000000000ull
 
 static FILE* log_fp = NULL;
+static LogRing log_ring = { .file = -1 };
+
+/*
+ * logger() is reachable from worker threads, so everything below that is shared
+ * (binary buffer, format table, sources, sinks) is only touched under this lock.
+ * Critical sections are a formatted line or one record (a ring rotation adds a
+ * memcpy; its archive files are written by logger_update()), so a spinlock that
+ * yields is enough and keeps the core free of a threads dependency.
+ */
+static atomic_flag log_lock_flag = ATOMIC_FLAG_INIT;
+
+static void log_lock(void) {
+    while (atomic_flag_test_and_set_explicit(&log_lock_flag, memory_order_acquire))
+        log_yield();
+}
+
+static void log_unlock(void) {
+    atomic_flag_clear_explicit(&log_lock_flag, memory_order_release);
+}
+
+typedef struct
+{
+    char* fmt;      // owned copy of the format text
+    uint64_t hash;
+    uint32_t id;
+} LogFormatEntry;
+
+static struct
+{
+    int enabled;
+    unsigned char buffer[LOG_BINARY_BUFFER_SIZE];
+    size_t len;
+    LogFormatEntry* formats;   // open addressing, keyed by format text
+    size_t format_count;
+    size_t format_capacity;
+} binary_log;
+
+static struct
+{
+    char* names[LOG_MAX_SOURCES];
+    LogLevel levels[LOG_MAX_SOURCES];
+    LogLevel default_level;
+    uint16_t count;
+} log_sources;
+
+// Source attributed to messages from this thread; workers log as Core unless they set one
+static _Thread_local uint16_t log_current_source = 0;
+
+// Lowest of all source levels, defaults and overrides; written under the log lock
+static _Atomic(LogLevel) log_level_floor = LL_DEBUG;
+
+/*
+ * Suppressed counts live here rather than in the LogRateLimit, so logger_update() can report
+ * them after a flood stops without touching limits owned by plugins that may be gone by then.
+ */
+typedef struct
+{
+    const LogRateLimit* limit;  // key only, never dereferenced
+    char fmt[96];               // format of the call site, for the report
+    uint64_t since_ns;          // first suppression since the last report
+    uint32_t count;
+    LogLevel level;
+    uint16_t source;
+} LogSuppressed;
+
+static LogSuppressed log_suppressed[LOG_SUPPRESSED_MAX];
+static atomic_size_t log_suppressed_count = 0; // read without the lock by logger_update()
+
+// Per-source levels requested before the source registered (CORE_LOG_LEVEL)
+static struct
+{
+    char name[64];
+    LogLevel level;
+} level_overrides[32];
+static size_t level_override_count = 0;
 
 // Create logs directory if it doesn't exist
 int ensure_logs_dir() {
@@ -45,8 +137,367 @@ void log_close() {
     }
 }
 
-// Core logging function
-void logger(LogLevel level, const char* fmt, ...) {
+const char* log_format_next(const char* fmt, LogFormatSpec* spec) {
+    for (;;) {
+        const char* p = strchr(fmt, '%');
+        if (!p)
+            return NULL;
+
+        spec->start = p;
+        spec->stars = 0;
+        spec->type = LA_NONE;
+        p++;
+
+        if (*p == '%') {
+            spec->len = 2;
+            return p + 1;
+        }
+
+        // flags, width, precision
+        while (*p && strchr("-+ #0'", *p)) p++;
+        if (*p == '*') { spec->stars++; p++; }
+        while (*p >= '0' && *p <= '9') p++;
+        if (*p == '.') {
+            p++;
+            if (*p == '*') { spec->stars++; p++; }
+            while (*p >= '0' && *p <= '9') p++;
+        }
+
+        // length modifier
+        LogArgType int_type = LA_INT;
+        LogArgType float_type = LA_DOUBLE;
+        switch (*p) {
+            case 'h': p++; if (*p == 'h') p++; break;
+            case 'l': p++; int_type = LA_LONG; if (*p == 'l') { p++; int_type = LA_LLONG; } break;
+            case 'z': p++; int_type = LA_SIZE; break;
+            case 'j': p++; int_type = LA_INTMAX; break;
+            case 't': p++; int_type = LA_PTRDIFF; break;
+            case 'L': p++; float_type = LA_LDOUBLE; break;
+        }
+
+        switch (*p) {
+            case 'd': case 'i': case 'u': case 'o': case 'x': case 'X':
+                spec->type = int_type; break;
+            case 'f': case 'F': case 'e': case 'E': case 'g': case 'G': case 'a': case 'A':
+                spec->type = float_type; break;
+            // `l` on c and s means wint_t and wchar_t*, not long
+            case 'c': spec->type = int_type == LA_LONG ? LA_WCHAR : LA_INT; break;
+            case 's': spec->type = int_type == LA_LONG ? LA_WSTRING : LA_STRING; break;
+            case 'p': spec->type = LA_POINTER; break;
+            case '\0': return NULL;
+            default: spec->type = LA_NONE; break; // %n and friends are not recorded
+        }
+        p++;
+        spec->len = (size_t)(p - spec->start);
+        return p;
+    }
+}
+
+static uint64_t log_timestamp_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_REALTIME, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+static void binary_flush(void) {
+    if (log_fp && binary_log.len) {
+        fwrite(binary_log.buffer, 1, binary_log.len, log_fp);
+        fflush(log_fp);
+    }
+    binary_log.len = 0;
+}
+
+static unsigned char* binary_reserve(size_t size) {
+    if (binary_log.len + size > LOG_BINARY_BUFFER_SIZE)
+        binary_flush();
+    if (size > LOG_BINARY_BUFFER_SIZE)
+        return NULL;
+    unsigned char* out = binary_log.buffer + binary_log.len;
+    binary_log.len += size;
+    return out;
+}
+
+static void binary_write_record(LogRecordKind kind, uint32_t id, const char* text, size_t len) {
+    unsigned char* out = binary_reserve(sizeof(LogRecordHeader) + len);
+    if (!out)
+        return;
+    LogRecordHeader h = {0};
+    h.kind = (uint8_t)kind;
+    h.source = log_current_source;
+    h.id = id;
+    h.size = (uint32_t)len;
+    h.timestamp_ns = log_timestamp_ns();
+    memcpy(out, &h, sizeof(h));
+    memcpy(out + sizeof(h), text, len);
+}
+
+static uint64_t format_hash(const char* fmt) {
+    uint64_t hash = 14695981039346656037ull;
+    for (const unsigned char* p = (const unsigned char*)fmt; *p; ++p)
+        hash = (hash ^ *p) * 1099511628211ull;
+    return hash;
+}
+
+static size_t format_slot(const LogFormatEntry* table, size_t capacity, const char* fmt, uint64_t hash) {
+    size_t mask = capacity - 1;
+    size_t idx = (size_t)hash & mask;
+    while (table[idx].fmt && (table[idx].hash != hash || strcmp(table[idx].fmt, fmt) != 0))
+        idx = (idx + 1) & mask;
+    return idx;
+}
+
+// Format strings are interned by content, so a reused (non-literal) buffer still decodes to the text it held
+static uint32_t binary_format_id(const char* fmt) {
+    if ((binary_log.format_count + 1) * 2 > binary_log.format_capacity) {
+        size_t new_capacity = binary_log.format_capacity ? binary_log.format_capacity * 2 : LOG_FORMAT_TABLE_INITIAL;
+        LogFormatEntry* table = calloc(new_capacity, sizeof(LogFormatEntry));
+        if (!table)
+            return 0;
+        for (size_t i = 0; i < binary_log.format_capacity; ++i) {
+            if (binary_log.formats[i].fmt)
+                table[format_slot(table, new_capacity, binary_log.formats[i].fmt, binary_log.formats[i].hash)] = binary_log.formats[i];
+        }
+        free(binary_log.formats);
+        binary_log.formats = table;
+        binary_log.format_capacity = new_capacity;
+    }
+
+    uint64_t hash = format_hash(fmt);
+    size_t idx = format_slot(binary_log.formats, binary_log.format_capacity, fmt, hash);
+    if (!binary_log.formats[idx].fmt) {
+        char* copy = strdup(fmt);
+        if (!copy)
+            return 0;
+        binary_log.formats[idx].fmt = copy;
+        binary_log.formats[idx].hash = hash;
+        binary_log.formats[idx].id = (uint32_t)++binary_log.format_count;
+        binary_write_record(LR_FORMAT, binary_log.formats[idx].id, fmt, strlen(fmt));
+    }
+    return binary_log.formats[idx].id;
+}
+
+// Records the raw arguments; formatting happens in build/log_decode
+static void binary_log_message(LogLevel level, const char* fmt, va_list args) {
+    unsigned char payload[1024];
+    size_t len = 0;
+    LogFormatSpec spec;
+    const char* p = fmt;
+
+    while ((p = log_format_next(p, &spec))) {
+        for (int i = 0; i < spec.stars; ++i) {
+            int64_t v = va_arg(args, int);
+            if (len + sizeof(v) > sizeof(payload)) goto done;
+            memcpy(payload + len, &v, sizeof(v));
+            len += sizeof(v);
+        }
+
+        int64_t iv = 0;
+        double dv = 0.0;
+        switch (spec.type) {
+            case LA_NONE: continue;
+            case LA_INT: iv = va_arg(args, int); break;
+            case LA_LONG: iv = va_arg(args, long); break;
+            case LA_LLONG: iv = va_arg(args, long long); break;
+            case LA_SIZE: iv = (int64_t)va_arg(args, size_t); break;
+            case LA_INTMAX: iv = va_arg(args, intmax_t); break;
+            case LA_PTRDIFF: iv = va_arg(args, ptrdiff_t); break;
+            case LA_POINTER: iv = (int64_t)(uintptr_t)va_arg(args, void*); break;
+            case LA_WCHAR: iv = (wint_t)va_arg(args, int); break; // wint_t may be promoted to int
+            case LA_DOUBLE: dv = va_arg(args, double); break;
+            case LA_LDOUBLE: dv = (double)va_arg(args, long double); break;
+            case LA_STRING: {
+                const char* str = va_arg(args, const char*);
+                if (!str) str = "(null)";
+                uint32_t slen = (uint32_t)strlen(str);
+                if (len + sizeof(slen) + slen > sizeof(payload))
+                    slen = (uint32_t)(len + sizeof(slen) < sizeof(payload) ? sizeof(payload) - len - sizeof(slen) : 0);
+                if (len + sizeof(slen) > sizeof(payload)) goto done;
+                memcpy(payload + len, &slen, sizeof(slen));
+                memcpy(payload + len + sizeof(slen), str, slen);
+                len += sizeof(slen) + slen;
+                continue;
+            }
+            case LA_WSTRING: {
+                const wchar_t* str = va_arg(args, const wchar_t*);
+                if (!str) str = L"(null)";
+                uint32_t slen = (uint32_t)wcslen(str);
+                if (len + sizeof(slen) > sizeof(payload)) goto done;
+                if (slen > (sizeof(payload) - len - sizeof(slen)) / sizeof(uint32_t))
+                    slen = (uint32_t)((sizeof(payload) - len - sizeof(slen)) / sizeof(uint32_t));
+                memcpy(payload + len, &slen, sizeof(slen));
+                len += sizeof(slen);
+                for (uint32_t i = 0; i < slen; ++i) {
+                    uint32_t ch = (uint32_t)str[i];
+                    memcpy(payload + len, &ch, sizeof(ch));
+                    len += sizeof(ch);
+                }
+                continue;
+            }
+        }
+
+        if (len + 8 > sizeof(payload)) goto done;
+        if (spec.type == LA_DOUBLE || spec.type == LA_LDOUBLE)
+            memcpy(payload + len, &dv, sizeof(dv));
+        else
+            memcpy(payload + len, &iv, sizeof(iv));
+        len += 8;
+    }
+
+done:;
+    uint32_t id = binary_format_id(fmt);
+    unsigned char* out = binary_reserve(sizeof(LogRecordHeader) + len);
+    if (!out)
+        return;
+    LogRecordHeader h = {0};
+    h.kind = LR_MESSAGE;
+    h.level = (uint8_t)level;
+    h.source = log_current_source;
+    h.id = id;
+    h.size = (uint32_t)len;
+    h.timestamp_ns = log_timestamp_ns();
+    memcpy(out, &h, sizeof(h));
+    memcpy(out + sizeof(h), payload, len);
+
+    // Errors are flushed right away so they survive a crash
+    if (level == LL_ERROR)
+        binary_flush();
+}
+
+uint16_t logger_register_source(const char* name) {
+    log_lock();
+    for (uint16_t i = 0; i < log_sources.count; ++i) {
+        if (strcmp(log_sources.names[i], name) == 0) {
+            log_unlock();
+            return i;
+        }
+    }
+    if (log_sources.count >= LOG_MAX_SOURCES) {
+        log_unlock();
+        return 0;
+    }
+
+    uint16_t id = log_sources.count++;
+    log_sources.names[id] = strdup(name);
+    log_sources.levels[id] = log_sources.default_level;
+    for (size_t i = 0; i < level_override_count; ++i) {
+        if (strcmp(level_overrides[i].name, name) == 0)
+            log_sources.levels[id] = level_overrides[i].level;
+    }
+    if (binary_log.enabled)
+        binary_write_record(LR_SOURCE, id, name, strlen(name));
+    log_unlock();
+    return id;
+}
+
+void logger_set_source(uint16_t source) {
+    log_current_source = source < log_sources.count ? source : 0;
+}
+
+static void update_level_floor(void) {
+    LogLevel floor = log_sources.default_level;
+    for (uint16_t i = 0; i < log_sources.count; ++i)
+        if (log_sources.levels[i] < floor)
+            floor = log_sources.levels[i];
+    for (size_t i = 0; i < level_override_count; ++i)
+        if (level_overrides[i].level < floor)
+            floor = level_overrides[i].level;
+    atomic_store_explicit(&log_level_floor, floor, memory_order_relaxed);
+}
+
+static void set_level(const char* source, LogLevel level) {
+    if (!source) {
+        log_sources.default_level = level;
+        for (uint16_t i = 0; i < log_sources.count; ++i)
+            log_sources.levels[i] = level;
+        level_override_count = 0;
+        return;
+    }
+
+    for (uint16_t i = 0; i < log_sources.count; ++i) {
+        if (strcmp(log_sources.names[i], source) == 0) {
+            log_sources.levels[i] = level;
+            return;
+        }
+    }
+
+    // Not registered yet; apply when it is
+    for (size_t i = 0; i < level_override_count; ++i) {
+        if (strcmp(level_overrides[i].name, source) == 0) {
+            level_overrides[i].level = level;
+            return;
+        }
+    }
+    if (level_override_count < sizeof(level_overrides) / sizeof(level_overrides[0])) {
+        snprintf(level_overrides[level_override_count].name, sizeof(level_overrides[0].name), "%s", source);
+        level_overrides[level_override_count].level = level;
+        level_override_count++;
+    }
+}
+
+void logger_set_level(const char* source, LogLevel level) {
+    log_lock();
+    set_level(source, level);
+    update_level_floor();
+    log_unlock();
+}
+
+LogLevel logger_get_level(uint16_t source) {
+    return source < log_sources.count ? log_sources.levels[source] : log_sources.default_level;
+}
+
+const _Atomic(LogLevel)* logger_level_floor(void) {
+    return &log_level_floor;
+}
+
+static int parse_level(const char* str, size_t len, LogLevel* out) {
+    static const struct { const char* name; LogLevel level; } names[] = {
+        { "debug", LL_DEBUG }, { "info", LL_INFO }, { "warn", LL_WARN }, { "error", LL_ERROR },
+    };
+    for (size_t i = 0; i < sizeof(names) / sizeof(names[0]); ++i) {
+        if (strlen(names[i].name) == len && strncmp(names[i].name, str, len) == 0) {
+            *out = names[i].level;
+            return 1;
+        }
+    }
+    return 0;
+}
+
+// CORE_LOG_LEVEL="info,Signals=debug,Lua=warn"
+static void parse_level_config(const char* config) {
+    while (config && *config) {
+        const char* end = strchr(config, ',');
+        size_t len = end ? (size_t)(end - config) : strlen(config);
+        const char* eq = memchr(config, '=', len);
+        LogLevel level;
+
+        if (eq) {
+            char name[64];
+            size_t name_len = (size_t)(eq - config);
+            if (name_len < sizeof(name) && parse_level(eq + 1, len - name_len - 1, &level)) {
+                memcpy(name, config, name_len);
+                name[name_len] = '\0';
+                logger_set_level(name, level);
+            }
+        } else if (parse_level(config, len, &level)) {
+            logger_set_level(NULL, level);
+        }
+
+        config = end ? end + 1 : NULL;
+    }
+}
+
+// Called with the logger lock held; it also serializes writes to the ring
+static void logger_va(LogLevel level, const char* fmt, va_list args) {
+    if (binary_log.enabled) {
+        va_list copy;
+        va_copy(copy, args);
+        binary_log_message(level, fmt, copy);
+        va_end(copy);
+
+        if (level != LL_WARN && level != LL_ERROR)
+            return;
+    }
+
     const char* prefix = "";
     switch (level) {
         case LL_INFO:  prefix = "[INFO]";  break;
@@ -62,38 +513,228 @@ void logger(LogLevel level, const char* fmt, ...) {
     char time_buf[20];
     strftime(time_buf, sizeof(time_buf), "%Y-%m-%d %H:%M:%S", t);
 
-    va_list args;
-    va_start(args, fmt);
+    // Format once, then hand the same line to every sink
+    char line[LOG_LINE_SIZE];
+    char* text = line;
+    int header_len = snprintf(line, sizeof(line), "[%s] %s ", time_buf, prefix);
+
+    va_list copy;
+    va_copy(copy, args);
+    int body_len = vsnprintf(line + header_len, sizeof(line) - header_len - 1, fmt, args);
+    if (body_len < 0)
+        body_len = 0;
+    if ((size_t)(header_len + body_len) >= sizeof(line) - 1) {
+        char* big = malloc((size_t)header_len + (size_t)body_len + 2);
+        if (big) {
+            memcpy(big, line, (size_t)header_len);
+            vsnprintf(big + header_len, (size_t)body_len + 1, fmt, copy);
+            text = big;
+        } else {
+            body_len = (int)sizeof(line) - header_len - 2;
+        }
+    }
+    va_end(copy);
+
+    size_t len = (size_t)(header_len + body_len);
+    text[len++] = '\n';
 
     // Console output
-    fprintf(stderr, "[%s] %s ", time_buf, prefix);
-    vfprintf(stderr, fmt, args);
-    fprintf(stderr, "\n");
+    fwrite(text, 1, len, stderr);
 
     // File output
-    if (log_fp) {
-        va_list copy;
-        va_copy(copy, args);
-        fprintf(log_fp, "[%s] %s ", time_buf, prefix);
-        vfprintf(log_fp, fmt, copy);
-        fprintf(log_fp, "\n");
+    if (log_ring.map) {
+        log_ring_write(&log_ring, text, len);
+    } else if (log_fp && !binary_log.enabled) {
+        fwrite(text, 1, len, log_fp);
         fflush(log_fp);
-        va_end(copy);
     }
 
+    if (text != line)
+        free(text);
+}
+
+// Core logging function
+void logger(LogLevel level, const char* fmt, ...) {
+    if (level < log_sources.levels[log_current_source])
+        return;
+
+    va_list args;
+    va_start(args, fmt);
+    log_lock();
+    logger_va(level, fmt, args);
+    log_unlock();
     va_end(args);
 }
 
+static void logger_locked(LogLevel level, const char* fmt, ...) {
+    va_list args;
+    va_start(args, fmt);
+    logger_va(level, fmt, args);
+    va_end(args);
+}
+
+static uint64_t log_monotonic_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+static void suppressed_report(size_t index) {
+    LogSuppressed* entry = &log_suppressed[index];
+    uint16_t source = log_current_source;
+    log_current_source = entry->source;
+    logger_locked(entry->level, "%u similar messages suppressed: %s", entry->count, entry->fmt);
+    log_current_source = source;
+
+    size_t count = atomic_load_explicit(&log_suppressed_count, memory_order_relaxed) - 1;
+    log_suppressed[index] = log_suppressed[count];
+    atomic_store_explicit(&log_suppressed_count, count, memory_order_relaxed);
+}
+
+static void suppressed_add(const LogRateLimit* limit, LogLevel level, const char* fmt, uint64_t now) {
+    size_t count = atomic_load_explicit(&log_suppressed_count, memory_order_relaxed);
+    for (size_t i = 0; i < count; ++i) {
+        if (log_suppressed[i].limit == limit) {
+            log_suppressed[i].count++;
+            return;
+        }
+    }
+    if (count == LOG_SUPPRESSED_MAX) {
+        suppressed_report(0);
+        count--;
+    }
+
+    LogSuppressed* entry = &log_suppressed[count];
+    entry->limit = limit;
+    snprintf(entry->fmt, sizeof(entry->fmt), "%s", fmt);
+    entry->since_ns = now;
+    entry->count = 1;
+    entry->level = level;
+    entry->source = log_current_source;
+    atomic_store_explicit(&log_suppressed_count, count + 1, memory_order_relaxed);
+}
+
+static void suppressed_take(const LogRateLimit* limit) {
+    size_t count = atomic_load_explicit(&log_suppressed_count, memory_order_relaxed);
+    for (size_t i = 0; i < count; ++i) {
+        if (log_suppressed[i].limit == limit) {
+            suppressed_report(i);
+            return;
+        }
+    }
+}
+
+// Token bucket per call site; repeats are counted and reported with the next message let through
+void logger_ratelimited(LogRateLimit* limit, LogLevel level, const char* fmt, ...) {
+    if (level < log_sources.levels[log_current_source])
+        return;
+
+    uint64_t now = log_monotonic_ns();
+    log_lock();
+    if (limit->last_ns == 0) {
+        limit->tokens = limit->burst;
+    } else if (now > limit->last_ns) {
+        limit->tokens += (float)((double)(now - limit->last_ns) * 1e-9 * limit->rate);
+        if (limit->tokens > limit->burst)
+            limit->tokens = limit->burst;
+    }
+    limit->last_ns = now;
+
+    if (limit->tokens < 1.0f) {
+        suppressed_add(limit, level, fmt, now);
+        log_unlock();
+        return;
+    }
+    limit->tokens -= 1.0f;
+
+    va_list args;
+    va_start(args, fmt);
+    logger_va(level, fmt, args);
+    va_end(args);
+    suppressed_take(limit);
+    log_unlock();
+}
+
+// Archives a rotated log ring and reports suppressed counts that have been pending for a while,
+// so a flood that stops is still accounted for
+void logger_update() {
+    // Outside the lock: writers only copy the ring aside, the file I/O happens here
+    log_ring_archive(&log_ring);
+
+    if (atomic_load_explicit(&log_suppressed_count, memory_order_relaxed) == 0)
+        return;
+
+    uint64_t now = log_monotonic_ns();
+    log_lock();
+    for (size_t i = 0; i < atomic_load_explicit(&log_suppressed_count, memory_order_relaxed);) {
+        if (now - log_suppressed[i].since_ns >= LOG_SUPPRESSED_REPORT_NS)
+            suppressed_report(i);
+        else
+            ++i;
+    }
+    log_unlock();
+}
+
 
 // Initialize logger: create directory, open file
 void logger_init() {
+    parse_level_config(getenv("CORE_LOG_LEVEL"));
+    logger_register_source("Core");
     ensure_logs_dir();
     char path[256];
     make_log_filename(path, sizeof(path));
-    init_file(path);
+
+    const char* format = getenv("CORE_LOG_FORMAT");
+    if (format && strcmp(format, "binary") == 0) {
+        // Swap ".log" for ".blog"
+        size_t n = strlen(path);
+        snprintf(path + n - 4, sizeof(path) - (n - 4), ".blog");
+        log_fp = fopen(path, "wb");
+        if (!log_fp) {
+            fprintf(stderr, "[LOG] Failed to open log file: %s\n", path);
+        } else {
+            LogBinaryFileHeader header = { LOG_BINARY_MAGIC, LOG_BINARY_VERSION, sizeof(LogRecordHeader) };
+            fwrite(&header, sizeof(header), 1, log_fp);
+            binary_log.enabled = 1;
+            for (uint16_t i = 0; i < log_sources.count; ++i)
+                binary_write_record(LR_SOURCE, i, log_sources.names[i], strlen(log_sources.names[i]));
+        }
+    } else if (getenv("CORE_LOG_RING_MB")) {
+        // Fixed-size mmap ring instead of a new unbounded file per run
+        size_t megabytes = strtoul(getenv("CORE_LOG_RING_MB"), NULL, 10);
+        const char* archives = getenv("CORE_LOG_ARCHIVES");
+        if (megabytes == 0)
+            megabytes = 1;
+        if (log_ring_open(&log_ring, LOG_RING_PATH, megabytes << 20, archives ? atoi(archives) : 0) != 0) {
+            fprintf(stderr, "[LOG] Failed to open log ring: %s\n", LOG_RING_PATH);
+            init_file(path);
+        }
+    } else {
+        init_file(path);
+    }
 }
 
 // Clean shutdown
 void logger_shutdown() {
+    log_lock();
+    while (atomic_load_explicit(&log_suppressed_count, memory_order_relaxed))
+        suppressed_report(0);
+    if (binary_log.enabled) {
+        binary_flush();
+        binary_log.enabled = 0;
+    }
+    for (size_t i = 0; i < binary_log.format_capacity; ++i)
+        free(binary_log.formats[i].fmt);
+    free(binary_log.formats);
+    binary_log.formats = NULL;
+    binary_log.format_count = binary_log.format_capacity = 0;
+    for (uint16_t i = 0; i < log_sources.count; ++i) {
+        free(log_sources.names[i]);
+        log_sources.names[i] = NULL;
+    }
+    log_sources.count = 0;
+    log_current_source = 0;
+    log_ring_close(&log_ring);
     log_close();
+    log_unlock();
 }
@@ -23,12 +23,19 @@ void mm_init(MemoryMap *mm, size_t buckets, malloc_fn_t _malloc, free_fn_t _free
     mm->_free = _free;
     mm->_hash = _hash;
     mm->buckets = _malloc(sizeof(MemoryBucket) * buckets);
+    if (!mm->buckets)
+    {
+        mm->capacity = 0; // start empty, the first insert retries the allocation
+        return;
+    }
+    memset(mm->buckets, 0, sizeof(MemoryBucket) * buckets);
 }
 
 void mm_check_optimize(MemoryMap *mm)
 {
-    if ((float)mm->count / mm->capacity > MM_LOAD_THRESHOLD)
-        mm_optimize(mm, MM_LOAD_THRESHOLD);
+    // Rehash to half the threshold so growth stays amortized instead of rehashing on every insert
+    if (!mm->capacity || (float)mm->count / mm->capacity > MM_LOAD_THRESHOLD)
+        mm_optimize(mm, MM_LOAD_THRESHOLD / 2);
 }
 
 void *mm_alloc(MemoryMap *mm, String name, size_t size)
@@ -44,7 +51,11 @@ void *mm_alloc(MemoryMap *mm, String name, size_t size)
 
 void mm_bind(MemoryMap *mm, String name, void *memory, size_t size, bool owned)
 {
-    
+    // Rehash before picking the bucket, the old buckets are freed by mm_optimize
+    mm_check_optimize(mm);
+    if (!mm->capacity)
+        return;
+
     size_t index = mm->_hash(name.data, name.len) % mm->capacity;
     MemoryBucket *bucket = &mm->buckets[index];
 
@@ -69,7 +80,16 @@ void mm_bind(MemoryMap *mm, String name, void *memory, size_t size, bool owned)
         }
     }
 
-    mm_check_optimize(mm);
+    if (bucket->count >= bucket->capacity)
+    {
+        MemoryEntry *entries = mm->_malloc(sizeof(MemoryEntry) * bucket->capacity * 2);
+        if (!entries)
+            return;
+        memcpy(entries, bucket->entries, sizeof(MemoryEntry) * bucket->count);
+        mm->_free(bucket->entries);
+        bucket->entries = entries;
+        bucket->capacity *= 2;
+    }
 
     // Insert new entry
     MemoryEntry *entry = &bucket->entries[bucket->count++];
@@ -85,6 +105,8 @@ void mm_bind(MemoryMap *mm, String name, void *memory, size_t size, bool owned)
 void *mm_get(MemoryMap *mm, String name)
 {
     mm_check_optimize(mm);
+    if (!mm->capacity)
+        return NULL;
     size_t index = mm->_hash(name.data, name.len) % mm->capacity;
     MemoryBucket *bucket = &mm->buckets[index];
     if (!bucket->entries)
@@ -103,6 +125,8 @@ void *mm_get(MemoryMap *mm, String name)
 
 size_t mm_get_size(MemoryMap *mm, String name)
 {
+    if (!mm->capacity)
+        return 0;
     size_t index = mm->_hash(name.data, name.len) % mm->capacity;
     MemoryBucket *bucket = &mm->buckets[index];
     if (!bucket->entries)
@@ -193,6 +217,8 @@ void mm_optimize(MemoryMap *mm, float target_load)
 int mm_remove(MemoryMap *mm, String name)
 {
     mm_check_optimize(mm);
+    if (!mm->capacity)
+        return 0;
     size_t index = mm->_hash(name.data, name.len) % mm->capacity;
     MemoryBucket *bucket = &mm->buckets[index];
     if (!bucket->entries)
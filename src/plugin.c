@@ -18,6 +18,12 @@
 #define DYNLIB_CLOSE(handle) dlclose(handle)
 #endif
 
+// Attributes log calls from the main thread to the plugin, and so to its runtime log level
+static void plugin_enter(const Plugin *plugin)
+{
+    logger_set_source(plugin ? plugin->log_source : 0);
+}
+
 void plugin_manager_new(PluginManager *pm, char *folder_path)
 {
     pm->plugins.list = NULL;
@@ -74,6 +80,7 @@ void plugin_manager_new(PluginManager *pm, char *folder_path)
             *plugin->api = load_func();
             plugin->handle = handle;
             plugin->name = strdup(entry->d_name);
+            plugin->log_source = logger_register_source(plugin->api->meta->name);
 
             logger(LL_INFO, "\t\tFound Plugin: %s", plugin->name);
         }
@@ -295,9 +302,11 @@ void plugin_manager_init(PluginManager *pm, CoreContext *ctx)
         ctx->log(LL_INFO, "\t\tLoading Plugin: %s", pm->plugins.list[i].api->meta->name);
         if (pm->plugins.list[i].api->init)
         {
+            plugin_enter(&pm->plugins.list[i]);
             pm->plugins.list[i].api->init(ctx);
         }
     }
+    plugin_enter(NULL);
 }
 
 
@@ -307,8 +316,12 @@ void plugin_manager_update(PluginManager *pm, CoreContext *ctx)
     for (i = 0; i < pm->plugins.len; i++)
     {
         if (pm->plugins.list[i].api->update)
+        {
+            plugin_enter(&pm->plugins.list[i]);
             pm->plugins.list[i].api->update(ctx);
+        }
     }
+    plugin_enter(NULL);
 }
 void plugin_manager_shutdown(PluginManager *pm, CoreContext *ctx)
 {
@@ -318,7 +331,9 @@ void plugin_manager_shutdown(PluginManager *pm, CoreContext *ctx)
     {
         if (pm->plugins.list[i].api->shutdown)
         {
+            plugin_enter(&pm->plugins.list[i]);
             pm->plugins.list[i].api->shutdown(ctx);
+            plugin_enter(NULL);
             ctx->log(LL_INFO, "\t\t+\t%s \tsuccessfully shutdown.", pm->plugins.list[i].api->meta->name);
         }
         else